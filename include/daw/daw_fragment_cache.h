@@ -0,0 +1,114 @@
+// The MIT License (MIT)
+//
+// Copyright (c) Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <daw/daw_string_view.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace daw {
+	/// A bounded, least recently used cache of the output of <%cache%> blocks.  Entries are keyed
+	/// by the block's key, so templates sharing a cache share the entries of blocks with the same
+	/// key.  The cache is split into shards, each with its own lock, so concurrent renders rarely
+	/// contend
+	class fragment_cache {
+	public:
+		using clock_t = std::chrono::steady_clock;
+		using value_t = std::shared_ptr<std::string const>;
+
+		struct statistics {
+			std::uint64_t hits = 0;
+			std::uint64_t misses = 0;
+			/// Entries removed to make space.  Expired entries are not counted
+			std::uint64_t evictions = 0;
+			std::size_t entries = 0;
+			std::size_t bytes = 0;
+		};
+
+		static constexpr std::size_t default_max_bytes = 16U * 1024U * 1024U;
+
+		explicit fragment_cache( std::size_t max_bytes = default_max_bytes );
+
+		fragment_cache( fragment_cache const & ) = delete;
+		fragment_cache &operator=( fragment_cache const & ) = delete;
+
+		/// The cached text for key, or null when there is none or it has expired
+		[[nodiscard]] value_t find( daw::string_view key );
+
+		/// Store text for key, replacing any current entry.  A ttl of zero never expires and the
+		/// entry is only removed when space is needed.  Text too large for the cache is not stored
+		void insert( daw::string_view key, std::string text, std::chrono::seconds ttl );
+
+		void clear( );
+
+		[[nodiscard]] statistics stats( ) const;
+
+		[[nodiscard]] std::size_t max_bytes( ) const noexcept {
+			return m_max_bytes;
+		}
+
+	private:
+		struct entry {
+			std::string key;
+			value_t text;
+			clock_t::time_point expires;
+			bool can_expire;
+
+			[[nodiscard]] std::size_t bytes( ) const noexcept {
+				return key.size( ) + text->size( );
+			}
+		};
+
+		struct shard {
+			mutable std::mutex mutex{ };
+			/// Most recently used first
+			std::list<entry> lru{ };
+			std::map<std::string, std::list<entry>::iterator, std::less<>> index{ };
+			std::size_t bytes = 0;
+
+			void erase( std::list<entry>::iterator pos );
+		};
+
+		static constexpr std::size_t shard_count = 16;
+
+		std::size_t m_max_bytes;
+		std::size_t m_shard_max_bytes;
+		std::array<shard, shard_count> m_shards{ };
+		std::atomic<std::uint64_t> m_hits{ 0 };
+		std::atomic<std::uint64_t> m_misses{ 0 };
+		std::atomic<std::uint64_t> m_evictions{ 0 };
+
+		shard &shard_for( daw::string_view key );
+	};
+} // namespace daw
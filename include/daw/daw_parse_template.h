@@ -22,6 +22,13 @@
 
 #pragma once
 
+#include "daw_fragment_cache.h"
+#include "daw_parse_template_escape.h"
+#include "daw_parse_template_image.h"
+#include "daw_parse_template_scan.h"
+#include "daw_parse_template_timestamp.h"
+#include "daw_render_profile.h"
+
 #include <daw/daw_arith_traits.h>
 #include <daw/daw_container_algorithm.h>
 #include <daw/daw_move.h>
@@ -34,10 +41,22 @@
 
 #include <date/date.h>
 #include <date/tz.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
 #include <map>
+#include <memory>
+#include <optional>
 #include <string>
 #include <string_view>
+#include <tuple>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace daw {
@@ -46,6 +65,8 @@ namespace daw {
 		callback_exception,
 		empty_tag,
 		eof,
+		include_cycle,
+		invalid_image,
 		io_error,
 		missing_dbl_quote,
 		missing_tag,
@@ -53,7 +74,9 @@ namespace daw {
 		precondition_violation,
 		unexpected_arg_count,
 		unexpected_dbl_quote,
+		unknown_escape,
 		unknown_function,
+		unknown_include,
 		unknown_tag,
 	};
 	struct escaped_string {
@@ -78,7 +101,9 @@ namespace daw {
 			bool in_quote = false;
 			bool is_escaped = false;
 			size_t last_pos = 0;
-			for( size_t n = 0; n < tag.size( ); ++n ) {
+			// Only quotes, backslashes, and commas change the state, so skip to the next one of them
+			for( size_t n = find_first_of( tag, '"', '\\', ',' ); n != daw::string_view::npos;
+			     n = find_first_of( tag, n + 1, '"', '\\', ',' ) ) {
 				switch( tag[n] ) {
 				case '"':
 					if( not is_escaped ) {
@@ -118,33 +143,31 @@ namespace daw {
 		template<typename T>
 		using actual_type_t = typename actual_type<T>::type;
 
-		std::string &to_string( std::string &str ) noexcept;
-		std::string to_string( std::string &&str ) noexcept;
+		/// The type a parsed argument is passed to a callback as.  The parsed arguments live as long
+		/// as the call site, so strings are passed by reference and converted to std::string_view or
+		/// copied only if the callback asks for it
+		template<typename T>
+		struct arg_ref_type {
+			using type = T;
+		};
 
-		template<typename ToStringFunc>
-		constexpr auto make_to_string_func( ToStringFunc func ) {
-			static_assert( std::is_invocable_v<ToStringFunc, daw::io::WriteProxy &> or
-			                 std::is_invocable_v<ToStringFunc, daw::io::WriteProxy &, void *>,
-			               "ToStringFunc must be callable with a WriteProxy argument func( writer )" );
-			return [func = std::move( func )]( daw::io::WriteProxy &writer, void *state ) {
-				if constexpr( std::is_invocable_v<ToStringFunc, daw::io::WriteProxy &> ) {
-					func( writer );
-				} else {
-					func( writer, state );
-				}
-			};
-		}
+		template<>
+		struct arg_ref_type<escaped_string> {
+			using type = std::string const &;
+		};
 
-		class doc_parts {
-			std::function<void( daw::io::WriteProxy &, void *state )> m_to_string;
+		template<typename T>
+		using arg_ref_type_t = typename arg_ref_type<T>::type;
 
-		public:
-			template<typename ToStringFunc>
-			doc_parts( ToStringFunc to_string_func )
-			  : m_to_string( make_to_string_func( std::move( to_string_func ) ) ) {}
+		template<typename Callback, typename... Args>
+		inline constexpr bool is_callback_invocable_v =
+		  std::is_invocable_v<Callback const &, Args..., daw::io::WriteProxy &, void *> or
+		  std::is_invocable_v<Callback const &, Args..., daw::io::WriteProxy &> or
+		  std::is_invocable_v<Callback const &, Args..., void *> or
+		  std::is_invocable_v<Callback const &, Args...>;
 
-			void operator( )( daw::io::WriteProxy &, void *state ) const;
-		};
+		std::string &to_string( std::string &str ) noexcept;
+		std::string to_string( std::string &&str ) noexcept;
 
 		template<typename Container>
 		using detect_is_range = decltype( std::distance( std::cbegin( std::declval<Container>( ) ),
@@ -168,24 +191,63 @@ namespace daw {
 		template<typename StringRange>
 		constexpr size_t value_size_v = value_size_test<StringRange>( );
 
+		/// Write str, escaped for escape
+		DAW_ATTRIB_INLINE daw::io::IOOpResult
+		write_output( daw::io::WriteProxy &writer, daw::string_view str, escape_mode escape ) {
+			if( escape == escape_mode::none ) {
+				return writer.write( str );
+			}
+			return write_escaped( writer, str, escape );
+		}
+
+		/// Escape output that is written to a WriteProxy by writing it to a buffer first.  write is
+		/// called with the WriteProxy to use
+		template<typename Write>
+		daw::io::IOOpResult
+		write_buffered( daw::io::WriteProxy &writer, escape_mode escape, Write &&write ) {
+			auto buffer = take_escape_buffer( );
+			auto buffer_writer = daw::io::WriteProxy( buffer );
+			auto wret = daw::io::IOOpResult{ };
+			wret.status = daw::io::IOOpStatus::Ok;
+			if constexpr( std::is_void_v<std::invoke_result_t<Write, daw::io::WriteProxy &>> ) {
+				write( buffer_writer );
+			} else {
+				wret = write( buffer_writer );
+			}
+			if( wret.status == daw::io::IOOpStatus::Ok ) {
+				wret = write_escaped( writer, buffer, escape );
+			}
+			release_escape_buffer( std::move( buffer ) );
+			return wret;
+		}
+
 		template<typename ErrorHandler, typename Callback, typename... Args>
 		constexpr void write_to_output_state( ErrorHandler const &on_error,
 		                                      Callback &callback,
 		                                      daw::io::WriteProxy &writer,
+		                                      escape_mode escape,
 		                                      void *state,
 		                                      Args &&...args ) {
 			auto wret = daw::io::IOOpResult{ };
 			using result_t = std::invoke_result_t<Callback, Args..., void *>;
 			try {
 				if constexpr( daw::traits::is_string_view_like_v<result_t> ) {
-					wret = writer.write( callback( DAW_FWD( args )..., state ) );
+					wret = write_output( writer, callback( DAW_FWD( args )..., state ), escape );
 				} else if constexpr( daw::io::type_writer::has_type_writer_v<result_t> ) {
-					wret = daw::io::type_writer::type_writer( writer, callback( DAW_FWD( args )..., state ) );
+					if( escape == escape_mode::none ) {
+						wret =
+						  daw::io::type_writer::type_writer( writer, callback( DAW_FWD( args )..., state ) );
+					} else {
+						wret = write_buffered( writer, escape, [&]( daw::io::WriteProxy &buffer_writer ) {
+							return daw::io::type_writer::type_writer( buffer_writer,
+							                                          callback( DAW_FWD( args )..., state ) );
+						} );
+					}
 				} else {
 					using parse_template_impl::to_string;
 					using std::to_string;
 					auto cb_res = callback( DAW_FWD( args )..., state );
-					wret = writer.write( to_string( cb_res ) );
+					wret = write_output( writer, to_string( cb_res ), escape );
 				}
 			} catch( std::exception &ex ) {
 				on_error( daw::parse_template_error_types::callback_exception, { }, ex.what( ) );
@@ -208,19 +270,27 @@ namespace daw {
 		constexpr void write_to_output_nostate( ErrorHandler const &on_error,
 		                                        Callback &callback,
 		                                        daw::io::WriteProxy &writer,
+		                                        escape_mode escape,
 		                                        Args &&...args ) {
 			auto wret = daw::io::IOOpResult{ };
 			using result_t = std::invoke_result_t<Callback, Args...>;
 			try {
 				if constexpr( daw::traits::is_string_view_like_v<result_t> ) {
-					wret = writer.write( callback( DAW_FWD( args )... ) );
+					wret = write_output( writer, callback( DAW_FWD( args )... ), escape );
 				} else if constexpr( daw::io::type_writer::has_type_writer_v<result_t> ) {
-					wret = daw::io::type_writer::type_writer( writer, callback( DAW_FWD( args )... ) );
+					if( escape == escape_mode::none ) {
+						wret = daw::io::type_writer::type_writer( writer, callback( DAW_FWD( args )... ) );
+					} else {
+						wret = write_buffered( writer, escape, [&]( daw::io::WriteProxy &buffer_writer ) {
+							return daw::io::type_writer::type_writer( buffer_writer,
+							                                          callback( DAW_FWD( args )... ) );
+						} );
+					}
 				} else {
 					using parse_template_impl::to_string;
 					using std::to_string;
 					auto cb_res = callback( DAW_FWD( args )... );
-					wret = writer.write( to_string( cb_res ) );
+					wret = write_output( writer, to_string( cb_res ), escape );
 				}
 			} catch( std::exception &ex ) {
 				on_error( daw::parse_template_error_types::callback_exception, { }, ex.what( ) );
@@ -239,36 +309,52 @@ namespace daw {
 			}
 		}
 
+		/// Callbacks taking the WriteProxy write to it directly, when their output is escaped they
+		/// write to a buffer that is escaped afterwards
 		template<typename... ArgTypes, typename ErrorHandler, typename Callback>
 		DAW_ATTRIB_FLATINLINE constexpr auto make_callback( ErrorHandler const &on_error,
 		                                                    Callback &callback,
 		                                                    daw::io::WriteProxy &writer,
-		                                                    void *state ) {
+		                                                    void *state,
+		                                                    escape_mode escape ) {
 			if constexpr( std::is_invocable_v<Callback,
 			                                  parse_template_impl::actual_type_t<ArgTypes>...,
 			                                  daw::io::WriteProxy &,
 			                                  void *> ) {
-				return [&, state]( parse_template_impl::actual_type_t<ArgTypes>... args ) mutable {
-					(void)callback( DAW_FWD( args )..., writer, state );
+				return [&, state, escape]( parse_template_impl::actual_type_t<ArgTypes>... args ) mutable {
+					if( escape == escape_mode::none ) {
+						(void)callback( DAW_FWD( args )..., writer, state );
+						return;
+					}
+					(void)write_buffered( writer, escape, [&]( daw::io::WriteProxy &buffer_writer ) {
+						(void)callback( DAW_FWD( args )..., buffer_writer, state );
+					} );
 				};
 			} else if constexpr( std::is_invocable_v<Callback,
 			                                         parse_template_impl::actual_type_t<ArgTypes>...,
 			                                         daw::io::WriteProxy &> ) {
-				return [&]( parse_template_impl::actual_type_t<ArgTypes>... args ) mutable {
-					(void)callback( DAW_FWD( args )..., writer );
+				return [&, escape]( parse_template_impl::actual_type_t<ArgTypes>... args ) mutable {
+					if( escape == escape_mode::none ) {
+						(void)callback( DAW_FWD( args )..., writer );
+						return;
+					}
+					(void)write_buffered( writer, escape, [&]( daw::io::WriteProxy &buffer_writer ) {
+						(void)callback( DAW_FWD( args )..., buffer_writer );
+					} );
 				};
 			} else if constexpr( std::is_invocable_v<Callback,
 			                                         parse_template_impl::actual_type_t<ArgTypes>...,
 			                                         void *> ) {
-				return [&, state]( parse_template_impl::actual_type_t<ArgTypes>... args ) mutable {
-					write_to_output_state( on_error, callback, writer, state, DAW_FWD( args )... );
+				return [&, state, escape]( parse_template_impl::actual_type_t<ArgTypes>... args ) mutable {
+					write_to_output_state( on_error, callback, writer, escape, state, DAW_FWD( args )... );
 				};
 			} else {
 				static_assert(
 				  std::is_invocable_v<Callback, parse_template_impl::actual_type_t<ArgTypes>...>,
-				  "Unsupported callback" );
-				return [&]( parse_template_impl::actual_type_t<ArgTypes>... args ) mutable {
-					write_to_output_nostate( on_error, callback, writer, DAW_FWD( args )... );
+				  "Unsupported callback.  Callbacks are invoked as const, mutable state belongs in the "
+				  "state passed to write_to/to_string" );
+				return [&, escape]( parse_template_impl::actual_type_t<ArgTypes>... args ) mutable {
+					write_to_output_nostate( on_error, callback, writer, escape, DAW_FWD( args )... );
 				};
 			}
 		}
@@ -277,13 +363,14 @@ namespace daw {
 		DAW_ATTRIB_FLATINLINE constexpr auto make_stateful_callback( ErrorHandler const &on_error,
 		                                                             Callback &&callback ) {
 			using state_t = std::remove_reference_t<StateType>;
-			if constexpr( std::is_invocable_v<Callback,
-			                                  actual_type_t<ArgTypes>...,
+			using callback_t = std::decay_t<Callback> const;
+			if constexpr( std::is_invocable_v<callback_t &,
+			                                  arg_ref_type_t<ArgTypes>...,
 			                                  daw::io::WriteProxy &,
 			                                  state_t &> ) {
-				return [&, callback = DAW_FWD( callback )]( auto &&...args,
-				                                            daw::io::WriteProxy &writer,
-				                                            void *state ) mutable {
+				return [on_error, callback = DAW_FWD( callback )]( arg_ref_type_t<ArgTypes>... args,
+				                                                   daw::io::WriteProxy &writer,
+				                                                   void *state ) {
 					if( not state ) {
 						on_error( parse_template_error_types::unknown_tag,
 						          daw::string_view{ },
@@ -293,8 +380,11 @@ namespace daw {
 					return callback( DAW_FWD( args )..., writer, *reinterpret_cast<state_t *>( state ) );
 				};
 			} else {
-				static_assert( std::is_invocable_v<Callback, actual_type_t<ArgTypes>..., state_t &> );
-				return [&, callback = DAW_FWD( callback )]( auto &&...args, void *state ) mutable {
+				static_assert( std::is_invocable_v<callback_t &, arg_ref_type_t<ArgTypes>..., state_t &>,
+				               "Unsupported callback.  Callbacks are invoked as const, mutable state "
+				               "belongs in the state passed to write_to/to_string" );
+				return [on_error, callback = DAW_FWD( callback )]( arg_ref_type_t<ArgTypes>... args,
+				                                                   void *state ) {
 					if( not state ) {
 						on_error( parse_template_error_types::unknown_tag,
 						          daw::string_view{ },
@@ -326,39 +416,225 @@ namespace daw {
 		template<typename Key, typename T, typename Allocator = std::allocator<std::pair<Key const, T>>>
 		using heterogenous_lookup_map_t = std::map<Key, T, std::less<>, Allocator>;
 
-		template<typename ErrorHandler>
-		struct raw_text_func {
-			daw::string_view str;
-			ErrorHandler const *on_error;
+		/// The position of text stored in a compiled template's arena
+		struct text_ref {
+			std::uint32_t first = 0;
+			std::uint32_t size = 0;
+		};
+
+		enum class op_code : std::uint8_t {
+			raw_text,
+			call,
+			date,
+			time,
+			timestamp,
+			flush,
+			cache_begin,
+			cache_end,
+			if_begin,
+			if_else,
+			if_end,
+			each_begin,
+			each_end
+		};
+
+		/// A single step of a compiled template.  For raw_text, index and size are the position of
+		/// the text in the arena.  For call it is the index of the call site, for date, time, and
+		/// timestamp it is the index of the time part, for cache_begin and cache_end it is the
+		/// index of the cache block, and for the if and each instructions it is the index of the
+		/// block site.  flush marks a <%flush%> tag
+		struct instruction {
+			op_code op;
+			std::uint32_t index;
+			std::uint32_t size = 0;
+		};
+
+		/// A <%cache args="key,ttl"%> ... <%endcache%> block.  end is the position of the
+		/// cache_end instruction in the program
+		struct cache_block {
+			text_ref key;
+			std::chrono::seconds ttl;
+			std::size_t end = 0;
+		};
+
+		/// Renders the body of an <%if%> or <%each%> block with the state passed to it
+		class block_body {
+			void const *m_context;
+			void ( *m_render )( void const *, void * );
+
+		public:
+			template<typename Render>
+			explicit block_body( Render const &render ) noexcept
+			  : m_context( std::addressof( render ) )
+			  , m_render( []( void const *context, void *state ) {
+				  ( *static_cast<Render const *>( context ) )( state );
+			  } ) {}
+
+			void operator( )( void *state ) const {
+				m_render( m_context, state );
+			}
+		};
+
+		/// An <%if%> or <%each%> block.  begin, else_pos, and end are the positions of its
+		/// instructions in the program, else_pos is end when there is no <%else%>.  The callback is
+		/// bound to test for an if and loop for an each
+		struct block_site {
+			text_ref name;
+			text_ref args;
+			std::size_t slot;
+			std::size_t begin;
+			std::size_t else_pos = 0;
+			std::size_t end = 0;
+			std::function<bool( void * )> test{ };
+			std::function<void( void *, block_body const & )> loop{ };
+		};
+
+		/// The render control used when nothing needs to flush or stop a render
+		struct no_render_control {
+			static constexpr void flush( ) noexcept {}
+
+			static constexpr bool stopped( ) noexcept {
+				return false;
+			}
+		};
+
+		/// The render control of parse_template::profile_to.  Each call, date, time, and timestamp
+		/// tag is timed and written to scratch first to count its bytes.  Other renders never
+		/// instantiate the profiling code
+		struct profile_control : no_render_control {
+			render_profile &profile;
+			std::string scratch{ };
+
+			explicit profile_control( render_profile &p )
+			  : profile( p ) {}
+		};
+
+		template<typename Control>
+		inline constexpr bool is_profile_control_v =
+		  std::is_same_v<std::decay_t<Control>, profile_control>;
+
+		/// Caches the output of a format and time zone for the current second.  A cache is shared by
+		/// every template using the same format and time zone.  Reading never blocks, when the value
+		/// is stale or is being refreshed the reader formats the time itself and, if no other thread
+		/// is refreshing it, stores the result for the following readers
+		class timestamp_cache {
+			static constexpr std::size_t word_count = 16;
+
+		public:
+			static constexpr std::size_t max_size = word_count * sizeof( std::uint64_t );
+			using buffer_t = std::array<char, max_size>;
+
+		private:
+			resolved_zone const *m_zone;
+			timestamp_formatter m_formatter;
+			// Odd while the value is being refreshed
+			std::atomic<std::uint64_t> m_sequence{ 0 };
+			std::atomic<std::int64_t> m_second{ std::numeric_limits<std::int64_t>::min( ) };
+			std::atomic<std::size_t> m_size{ 0 };
+			std::array<std::atomic<std::uint64_t>, word_count> m_words{ };
+
+			[[nodiscard]] bool try_load( std::int64_t second, buffer_t &buffer, std::size_t &size ) const;
+			void try_store( std::int64_t second, daw::string_view value );
+
+		public:
+			timestamp_cache( resolved_zone const &zone, daw::string_view fmt );
+
+			/// Get the formatted value for the current time.  The result refers to either buffer or
+			/// overflow, overflow is used when the value is not cached
+			daw::string_view get( buffer_t &buffer, std::string &overflow );
+		};
+
+		/// Get the process wide cache for fmt in the time zone zone
+		timestamp_cache &get_timestamp_cache( resolved_zone const &zone, daw::string_view fmt );
+
+		/// A date, time, or timestamp tag.  fmt refers to the format string in the arena and offset
+		/// is the position of the tag in the template source
+		struct time_part {
+			resolved_zone const *zone;
+			text_ref fmt;
+			timestamp_cache *cache;
+			std::size_t offset;
+			op_code op;
+		};
+
+		/// Used to estimate the output size of parts whose size is only known when rendering
+		inline constexpr std::size_t call_size_estimate = 32;
+		inline constexpr std::size_t date_size_estimate = 10;
+		inline constexpr std::size_t time_size_estimate = 8;
+
+		constexpr std::size_t timestamp_size_estimate( daw::string_view fmt ) noexcept {
+			// Most conversion specifiers expand to 2-4 characters from the 2 in the format
+			return fmt.size( ) * 2;
+		}
 
-			explicit constexpr raw_text_func( ErrorHandler const &error_handler, daw::string_view sv )
-			  : str( sv )
-			  , on_error( &error_handler ) {}
+		/// The expected output size of a template, learned from recent renders.  The hint rises at
+		/// once to a larger output and decays by an eighth of the difference after each smaller one,
+		/// so it follows the recent high-water mark.  It is only written when it changes, as many
+		/// threads may be rendering the same template
+		class output_size_hint {
+			std::atomic<std::size_t> m_hint{ 0 };
 
-			template<typename Writer>
-			constexpr void operator( )( Writer &writer ) const {
-				auto ret = writer.write( str );
-				if( ret.status != io::IOOpStatus::Ok ) {
-					( *on_error )( parse_template_error_types::io_error, str, "Error writing to output" );
+		public:
+			/// The hint, or 0 when nothing has been rendered yet
+			[[nodiscard]] std::size_t get( ) const noexcept {
+				return m_hint.load( std::memory_order_relaxed );
+			}
+
+			void record( std::size_t size ) noexcept {
+				auto const hint = m_hint.load( std::memory_order_relaxed );
+				auto const next = size >= hint ? size : hint - ( hint - size ) / 8;
+				if( next != hint ) {
+					m_hint.store( next, std::memory_order_relaxed );
 				}
 			}
 		};
-		template<typename ErrorHandler>
-		raw_text_func( ErrorHandler const &, daw::string_view ) -> raw_text_func<ErrorHandler>;
 
-		constexpr size_t find_quote( daw::string_view str ) noexcept {
-			bool in_slash = false;
-			for( size_t n = 0; n < str.size( ); ++n ) {
-				if( str[n] == '\\' ) {
-					in_slash = true;
-					continue;
-				} else {
-					if( str[n] == '"' ) {
-						if( not in_slash ) {
-							return n;
-						}
-					}
-					in_slash = false;
+		/// Make room for size more bytes when wr is a std::string.  The capacity grows geometrically
+		/// so that appending many renders to one string does not reallocate for each of them
+		template<typename Writable>
+		void reserve_output( Writable &wr, std::size_t size ) {
+			if constexpr( std::is_same_v<Writable, std::string> ) {
+				if( wr.capacity( ) - wr.size( ) < size ) {
+					wr.reserve( std::max( 2 * wr.capacity( ), wr.size( ) + size ) );
+				}
+			}
+		}
+
+		/// A call tag in the template.  The arguments are parsed once when a callback is bound to
+		/// the name, invoke then holds the callback along with the parsed arguments.  offset is the
+		/// position of the tag in the template source.  escape is the tag's escape attribute, when
+		/// it has none the template's default is used
+		struct call_site {
+			text_ref name;
+			text_ref args;
+			std::size_t slot;
+			std::size_t offset;
+			std::optional<escape_mode> escape;
+			std::function<void( daw::io::WriteProxy &, void *, escape_mode )> invoke{ };
+		};
+
+		/// A callback name used by the template.  Names are resolved to a slot when the template is
+		/// compiled and the slot refers to every call and block site using it.  Call sites are bound
+		/// by add_callback and block sites by add_block_callback
+		struct callback_slot {
+			daw::string_view name;
+			std::vector<std::size_t> call_sites{ };
+			std::vector<std::size_t> block_sites{ };
+			bool is_bound = false;
+			bool blocks_bound = false;
+
+			[[nodiscard]] bool is_missing( ) const noexcept {
+				return ( not call_sites.empty( ) and not is_bound ) or
+				       ( not block_sites.empty( ) and not blocks_bound );
+			}
+		};
+
+		/// Position of the first double-quote in str that is not preceded by a backslash, or npos
+		inline size_t find_quote( daw::string_view str ) noexcept {
+			for( size_t n = find_first_of( str, '"', '"', '"' ); n != daw::string_view::npos;
+			     n = find_first_of( str, n + 1, '"', '"', '"' ) ) {
+				if( n == 0 or str[n - 1] != '\\' ) {
+					return n;
 				}
 			}
 			return daw::string_view::npos;
@@ -381,34 +657,48 @@ namespace daw {
 			return tag;
 		}
 
+		/// The value of the escape="..." attribute in part, part of a tag with the args attribute
+		/// removed, or null when there is none
 		template<typename ErrorHandler>
-		class date_tag_func {
-			date::time_zone const *tz;
-			ErrorHandler const *on_error;
-
-		public:
-			explicit constexpr date_tag_func( ErrorHandler const &eh,
-			                                  date::time_zone const *timezone ) noexcept
-			  : tz( timezone )
-			  , on_error( &eh ) {}
-
-			template<typename Writer>
-			void operator( )( Writer &writer ) const {
-				using namespace date;
-				using namespace std::chrono;
-				std::stringstream ss{ };
-				auto const current_time = date::make_zoned( tz, std::chrono::system_clock::now( ) );
-				ss << date::format( "%Y-%m-%d", current_time );
-				auto ret = writer.write( ss.str( ) );
-				if( ret.status != io::IOOpStatus::Ok ) {
-					( *on_error )( parse_template_error_types::io_error,
-					               ss.str( ),
-					               "Error writing to output" );
+		std::optional<daw::string_view> find_escape_attribute( ErrorHandler const &on_error,
+		                                                       daw::string_view part ) {
+			using namespace daw::string_view_literals;
+			constexpr auto attribute = R"(escape=")"_sv;
+			for( auto pos = part.find( attribute ); pos != daw::string_view::npos;
+			     pos = part.find( attribute, pos + 1 ) ) {
+				if( pos != 0 and not daw::parser::is_unicode_whitespace( part[pos - 1] ) ) {
+					continue;
 				}
+				auto value = part.substr( pos + attribute.size( ) );
+				auto const end_quote_pos = value.find( '"' );
+				if( end_quote_pos == daw::string_view::npos ) {
+					on_error( parse_template_error_types::missing_dbl_quote,
+					          part,
+					          "Could not find end of escape" );
+				}
+				return value.substr( 0, end_quote_pos );
 			}
-		};
+			return std::nullopt;
+		}
+
+		template<typename ErrorHandler>
+		void write_text( ErrorHandler const &on_error,
+		                 daw::io::WriteProxy &writer,
+		                 daw::string_view str ) {
+			auto ret = writer.write( str );
+			if( DAW_UNLIKELY( ret.status != io::IOOpStatus::Ok ) ) {
+				on_error( parse_template_error_types::io_error, str, "Error writing to output" );
+			}
+		}
+
 		template<typename ErrorHandler>
-		date_tag_func( ErrorHandler const &, date::time_zone const * ) -> date_tag_func<ErrorHandler>;
+		void write_timestamp( ErrorHandler const &on_error,
+		                      daw::io::WriteProxy &writer,
+		                      timestamp_cache &cache ) {
+			auto buffer = timestamp_cache::buffer_t{ };
+			auto overflow = std::string( );
+			write_text( on_error, writer, cache.get( buffer, overflow ) );
+		}
 
 		template<typename ErrorHandler>
 		class ErrorWrapper {
@@ -433,106 +723,649 @@ namespace daw {
 				std::terminate( );
 			}
 		};
+
+		/// A shared_ptr that is loaded and replaced atomically
+		template<typename T>
+		class atomic_shared_ptr {
+#if defined( __cpp_lib_atomic_shared_ptr )
+			std::atomic<std::shared_ptr<T>> m_ptr{ };
+
+		public:
+			[[nodiscard]] std::shared_ptr<T> load( ) const noexcept {
+				return m_ptr.load( std::memory_order_acquire );
+			}
+
+			void store( std::shared_ptr<T> ptr ) noexcept {
+				m_ptr.store( std::move( ptr ), std::memory_order_release );
+			}
+#else
+			std::shared_ptr<T> m_ptr{ };
+
+		public:
+			[[nodiscard]] std::shared_ptr<T> load( ) const noexcept {
+				return std::atomic_load_explicit( &m_ptr, std::memory_order_acquire );
+			}
+
+			void store( std::shared_ptr<T> ptr ) noexcept {
+				std::atomic_store_explicit( &m_ptr, std::move( ptr ), std::memory_order_release );
+			}
+#endif
+		};
+
+		/// The output of a pure callback for one set of arguments.  generation is the generation of
+		/// the callback's handle it was evaluated in
+		struct pure_value {
+			std::string text;
+			std::uint64_t generation;
+			std::chrono::steady_clock::time_point expires;
+		};
+
+		/// The cached output of a pure callback for the call sites with the same arguments.  value
+		/// cannot be moved, so the cache is constructed in place
+		struct pure_cache {
+			std::shared_ptr<std::atomic<std::uint64_t> const> generation;
+			std::chrono::seconds ttl;
+			atomic_shared_ptr<pure_value const> value{ };
+
+			pure_cache( std::shared_ptr<std::atomic<std::uint64_t> const> cache_generation,
+			            std::chrono::seconds cache_ttl )
+			  : generation( std::move( cache_generation ) )
+			  , ttl( cache_ttl ) {}
+		};
 	} // namespace parse_template_impl
 	  //*****************************************************************
 
+	/// Discards the cached output of a pure callback, see parse_template::add_pure_callback.
+	/// Copies refer to the same callback, so one handle can be passed to add_pure_callback for
+	/// several callbacks or templates that are invalidated together
+	class pure_callback_handle {
+		std::shared_ptr<std::atomic<std::uint64_t>> m_generation =
+		  std::make_shared<std::atomic<std::uint64_t>>( 0 );
+
+	public:
+		/// Each cached value is evaluated again when it is next rendered.  Safe to call while
+		/// rendering, renders in flight may still write the previous value
+		void invalidate( ) const noexcept {
+			m_generation->fetch_add( 1, std::memory_order_acq_rel );
+		}
+
+		[[nodiscard]] std::shared_ptr<std::atomic<std::uint64_t> const> generation( ) const noexcept {
+			return m_generation;
+		}
+	};
+
+	/// The output of parse_template::render_batch.  Every item is rendered into one buffer and
+	/// item i is the text from offsets[i] to offsets[i + 1].  Reuse one across batches to reuse its
+	/// memory
+	struct render_batch_output {
+		std::string buffer{ };
+		std::vector<std::size_t> offsets{ };
+
+		/// The number of items rendered
+		[[nodiscard]] std::size_t size( ) const noexcept {
+			return offsets.empty( ) ? 0 : offsets.size( ) - 1;
+		}
+
+		[[nodiscard]] daw::string_view operator[]( std::size_t index ) const noexcept {
+			return daw::string_view( buffer.data( ) + offsets[index],
+			                         offsets[index + 1] - offsets[index] );
+		}
+
+		void clear( ) noexcept {
+			buffer.clear( );
+			offsets.clear( );
+		}
+	};
+
 	template<typename ErrorHandler = parse_template_impl::default_error_handler_t>
 	class parse_template {
-		using callback_map_t = parse_template_impl::heterogenous_lookup_map_t<
-		  std::string,
-		  std::function<void( daw::string_view, daw::io::WriteProxy &, void * )>>;
-
 		DAW_NO_UNIQUE_ADDRESS parse_template_impl::ErrorWrapper<ErrorHandler> m_on_error{ };
-		std::vector<parse_template_impl::doc_parts> m_doc_builder{ };
-		callback_map_t m_callbacks{ };
+		std::vector<parse_template_impl::instruction> m_program{ };
+		std::string m_arena{ };
+		std::vector<parse_template_impl::call_site> m_call_sites{ };
+		std::vector<parse_template_impl::time_part> m_time_parts{ };
+		std::vector<parse_template_impl::callback_slot> m_slots{ };
+		std::vector<parse_template_impl::cache_block> m_cache_blocks{ };
+		std::vector<parse_template_impl::block_site> m_block_sites{ };
+		/// The begin instructions of the blocks not yet closed while compiling, innermost last
+		std::vector<parse_template_impl::instruction> m_open_blocks{ };
+		std::shared_ptr<fragment_cache> m_fragment_cache{ };
+		parse_template_impl::heterogenous_lookup_map_t<std::string, std::size_t> m_slot_lookup{ };
+		std::size_t m_static_size = 0;
+		std::size_t m_dynamic_size_estimate = 0;
+		mutable std::atomic<bool> m_is_finalized{ false };
+		mutable parse_template_impl::output_size_hint m_size_hint{ };
+		/// The offset in the template source of the tag being compiled
+		std::size_t m_tag_offset = 0;
+		escape_mode m_default_escape = escape_mode::none;
 
 	public:
+		/// Returns the compiled template an <%include args="name"%> tag refers to, or null when
+		/// there is none
+		using include_resolver = std::function<parse_template const *( daw::string_view name )>;
+
 		explicit parse_template( daw::string_view template_string ) {
-			process_template( template_string );
+			process_template( template_string, nullptr );
 		}
 
 		explicit parse_template( daw::string_view template_string, ErrorHandler on_error )
 		  : m_on_error( std::move( on_error ) ) {
 
-			process_template( template_string );
+			process_template( template_string, nullptr );
+		}
+
+		/// Compile template_string, splicing the parts of each template named by an include tag
+		/// into this one.  Included call tags are bound by this template's add_callback
+		parse_template( daw::string_view template_string, include_resolver const &resolve_include ) {
+			process_template( template_string, &resolve_include );
+		}
+
+		parse_template( daw::string_view template_string,
+		                include_resolver const &resolve_include,
+		                ErrorHandler on_error )
+		  : m_on_error( std::move( on_error ) ) {
+
+			process_template( template_string, &resolve_include );
+		}
+
+		/// Arguments parsed for a call site may be views of the compiled text, and renders update the
+		/// finalized flag and size hint in place, so a template is neither copied nor moved.  Keep it
+		/// in a std::unique_ptr or std::shared_ptr to hand it around
+		parse_template( parse_template const & ) = delete;
+		parse_template( parse_template && ) = delete;
+		parse_template &operator=( parse_template const & ) = delete;
+		parse_template &operator=( parse_template && ) = delete;
+
+		/// Load a template from an image written by write_image.  Nothing is parsed again, and time
+		/// zones are resolved by name.  Callbacks are added by name afterwards, as for a template
+		/// that was compiled.  Errors in the image are reported as invalid_image
+		parse_template( template_image_t, daw::string_view image ) {
+			load_image( image );
+		}
+
+		parse_template( template_image_t, daw::string_view image, ErrorHandler on_error )
+		  : m_on_error( std::move( on_error ) ) {
+
+			load_image( image );
+		}
+
+		/// Append a binary image of the compiled template to out, for loading with the template_image
+		/// constructor in place of compiling the template again.  Included templates are part of the
+		/// image.  Tags using the system's time zone use the time zone of the machine loading the
+		/// image
+		void write_image( std::string &out ) const {
+			auto text = m_arena;
+			auto const add_text = [&]( daw::string_view str ) {
+				auto const first = static_cast<std::uint32_t>( text.size( ) );
+				text.append( str.data( ), str.size( ) );
+				return parse_template_impl::image_text{ first, static_cast<std::uint32_t>( str.size( ) ) };
+			};
+			auto const arena_ref = []( parse_template_impl::text_ref ref ) {
+				return parse_template_impl::image_text{ ref.first, ref.size };
+			};
+			auto records = std::vector<parse_template_impl::image_record>( );
+			records.reserve( m_program.size( ) );
+			for( auto const &inst : m_program ) {
+				auto record = parse_template_impl::image_record{ };
+				record.op = static_cast<std::uint8_t>( inst.op );
+				switch( inst.op ) {
+				case parse_template_impl::op_code::raw_text:
+					record.first = parse_template_impl::image_text{ inst.index, inst.size };
+					break;
+				case parse_template_impl::op_code::call: {
+					auto const &site = m_call_sites[inst.index];
+					record.first = arena_ref( site.name );
+					record.second = arena_ref( site.args );
+					record.value = site.offset;
+					if( site.escape ) {
+						record.escape = static_cast<std::uint8_t>( *site.escape );
+						++record.escape;
+					}
+					break;
+				}
+				case parse_template_impl::op_code::date:
+				case parse_template_impl::op_code::time:
+				case parse_template_impl::op_code::timestamp: {
+					auto const &part = m_time_parts[inst.index];
+					record.first = add_text( part.zone->name( ) );
+					record.second = arena_ref( part.fmt );
+					record.value = part.offset;
+					break;
+				}
+				case parse_template_impl::op_code::cache_begin: {
+					auto const &block = m_cache_blocks[inst.index];
+					record.first = arena_ref( block.key );
+					record.value = static_cast<std::uint64_t>( block.ttl.count( ) );
+					break;
+				}
+				case parse_template_impl::op_code::if_begin:
+				case parse_template_impl::op_code::each_begin: {
+					auto const &site = m_block_sites[inst.index];
+					record.first = arena_ref( site.name );
+					record.second = arena_ref( site.args );
+					break;
+				}
+				default:
+					break;
+				}
+				records.push_back( record );
+			}
+			if( DAW_UNLIKELY( text.size( ) >= std::numeric_limits<std::uint32_t>::max( ) ) ) {
+				m_on_error( parse_template_error_types::precondition_violation,
+				            { },
+				            "Template is too large" );
+			}
+			out.reserve( out.size( ) + parse_template_impl::image_header_size +
+			             records.size( ) * parse_template_impl::image_record_size + text.size( ) );
+			parse_template_impl::append_image_header(
+			  out,
+			  parse_template_impl::image_header{ static_cast<std::uint32_t>( records.size( ) ),
+			                                     static_cast<std::uint32_t>( text.size( ) ),
+			                                     static_cast<std::uint8_t>( m_default_escape ) } );
+			for( auto const &record : records ) {
+				parse_template_impl::append_image_record( out, record );
+			}
+			out += text;
+		}
+
+		[[nodiscard]] std::string to_image( ) const {
+			auto result = std::string( );
+			write_image( result );
+			return result;
 		}
 
 		template<typename Writable>
-		void write_to( Writable &wr ) {
+		void write_to( Writable &wr ) const {
+			parse_template_impl::reserve_output( wr, size_hint( ) );
 			return write_to( daw::io::WriteProxy( wr ) );
 		}
 
 		template<typename Writable, typename T>
-		void write_to( Writable &wr, T &&state ) {
+		void write_to( Writable &wr, T &&state ) const {
+			parse_template_impl::reserve_output( wr, size_hint( ) );
 			return write_to( daw::io::WriteProxy( wr ), state );
 		}
 
-		std::string to_string( ) {
+		std::string to_string( ) const {
 			auto result = std::string( );
-			write_to( daw::io::WriteProxy( result ) );
+			render_into( result );
 			return result;
 		}
 
 		template<typename T>
-		std::string to_string( T &state ) {
+		std::string to_string( T &state ) const {
 			auto result = std::string( );
-			write_to( daw::io::WriteProxy( result ), state );
+			render_into( result, state );
 			return result;
 		}
 
-		inline void write_to( daw::io::WriteProxy &&writable ) {
+		/// Render into reuse, replacing its contents but keeping its capacity, so that rendering
+		/// repeatedly into the same string stops allocating once it has grown to the output size
+		std::string &render_into( std::string &reuse ) const {
+			reuse.clear( );
+			reuse.reserve( size_hint( ) );
+			write_to( daw::io::WriteProxy( reuse ) );
+			m_size_hint.record( reuse.size( ) );
+			return reuse;
+		}
+
+		template<typename T>
+		std::string &render_into( std::string &reuse, T &state ) const {
+			reuse.clear( );
+			reuse.reserve( size_hint( ) );
+			write_to( daw::io::WriteProxy( reuse ), state );
+			m_size_hint.record( reuse.size( ) );
+			return reuse;
+		}
+
+		/// Escape the output of call tags that have no escape attribute.  This applies to included
+		/// call tags as well, the default of the included template is not used
+		void set_default_escape( escape_mode escape ) noexcept {
+			m_default_escape = escape;
+		}
+
+		[[nodiscard]] escape_mode default_escape( ) const noexcept {
+			return m_default_escape;
+		}
+
+		/// The number of bytes of literal text the template outputs
+		[[nodiscard]] std::size_t static_size( ) const noexcept {
+			return m_static_size;
+		}
+
+		/// The estimated number of bytes a render outputs.  This is the size of the literal text
+		/// plus an estimate for each call, date, time, and timestamp tag
+		[[nodiscard]] std::size_t size_estimate( ) const noexcept {
+			return m_static_size + m_dynamic_size_estimate;
+		}
+
+		/// The expected number of bytes a render outputs, for sizing the buffer rendered into.  This
+		/// follows the high-water mark of recent to_string and render_batch output and is
+		/// size_estimate( ) until the first of them
+		[[nodiscard]] std::size_t size_hint( ) const noexcept {
+			auto const hint = m_size_hint.get( );
+			return hint != 0 ? hint : size_estimate( );
+		}
+
+		inline void write_to( daw::io::WriteProxy &&writable ) const {
 			write_to_impl( writable, nullptr );
 		}
 
-		inline void write_to( daw::io::WriteProxy &writable ) {
+		inline void write_to( daw::io::WriteProxy &writable ) const {
 			write_to_impl( writable, nullptr );
 		}
 
 		template<typename T>
-		inline void write_to( daw::io::WriteProxy &writable, T &state ) {
+		inline void write_to( daw::io::WriteProxy &writable, T &state ) const {
 			static_assert( not std::is_const_v<T>, "Only mutable state is supported" );
 			void *state_ptr = reinterpret_cast<void *>( std::addressof( state ) );
 			write_to_impl( writable, state_ptr );
 		}
 
 		template<typename T>
-		inline void write_to( daw::io::WriteProxy &&writable, T &state ) {
+		inline void write_to( daw::io::WriteProxy &&writable, T &state ) const {
 			write_to( writable, state );
 		}
 
-		template<typename... Args, typename Callback, typename Splitter>
-		constexpr decltype( auto )
-		apply_from_string( Callback &cb, daw::string_view sv, Splitter &&sp ) {
-			auto parse_value = [&]( daw::string_view &sv, auto Tag ) {
-				auto part = sv.pop_front_until( sp );
+		/// Render the template once for each state in [first, last) into output, replacing its
+		/// contents.  The bindings are checked once and a single writer and buffer are used for the
+		/// whole batch
+		template<typename Iterator>
+		void render_batch( Iterator first, Iterator last, render_batch_output &output ) const {
+			output.clear( );
+			if( DAW_UNLIKELY( not is_finalized( ) ) ) {
+				check_bindings( );
+			}
+			auto const count = static_cast<std::size_t>( std::distance( first, last ) );
+			output.offsets.reserve( count + 1 );
+			output.offsets.push_back( 0 );
+			if( count == 0 ) {
+				return;
+			}
+			output.buffer.reserve( count * size_hint( ) );
+			auto writer = daw::io::WriteProxy( output.buffer );
+			auto on_literal = [&]( daw::string_view text ) {
+				parse_template_impl::write_text( m_on_error, writer, text );
+			};
+			for( ; first != last; ++first ) {
+				auto &state = *first;
+				static_assert( not std::is_const_v<std::remove_reference_t<decltype( state )>>,
+				               "Only mutable state is supported" );
+				auto const item_first = output.buffer.size( );
+				render_program( writer, reinterpret_cast<void *>( std::addressof( state ) ), on_literal );
+				m_size_hint.record( output.buffer.size( ) - item_first );
+				output.offsets.push_back( output.buffer.size( ) );
+				if( output.offsets.size( ) == 2 ) {
+					// Now that the size of a real item is known, use it to size the buffer for the rest
+					output.buffer.reserve( output.buffer.size( ) * count + count );
+				}
+			}
+		}
+
+		template<typename Range>
+		void render_batch( Range &states, render_batch_output &output ) const {
+			render_batch( std::begin( states ), std::end( states ), output );
+		}
+
+		/// Render the template once for each state in [first, last), calling sink with the index of
+		/// the state and its output.  The view passed to sink is only valid during the call, as the
+		/// buffer behind it is reused for the next item
+		template<typename Iterator,
+		         typename Sink,
+		         std::enable_if_t<std::is_invocable_v<Sink, std::size_t, daw::string_view>,
+		                          std::nullptr_t> = nullptr>
+		void render_batch( Iterator first, Iterator last, Sink &&sink ) const {
+			if( DAW_UNLIKELY( not is_finalized( ) ) ) {
+				check_bindings( );
+			}
+			auto buffer = std::string( );
+			buffer.reserve( size_hint( ) );
+			auto writer = daw::io::WriteProxy( buffer );
+			auto on_literal = [&]( daw::string_view text ) {
+				parse_template_impl::write_text( m_on_error, writer, text );
+			};
+			for( std::size_t index = 0; first != last; ++first, ++index ) {
+				auto &state = *first;
+				static_assert( not std::is_const_v<std::remove_reference_t<decltype( state )>>,
+				               "Only mutable state is supported" );
+				buffer.clear( );
+				render_program( writer, reinterpret_cast<void *>( std::addressof( state ) ), on_literal );
+				m_size_hint.record( buffer.size( ) );
+				sink( index, daw::string_view( buffer.data( ), buffer.size( ) ) );
+			}
+		}
+
+		/// Render the template to writer, calling control.flush( ) at each <%flush%> tag.  Before each
+		/// part control.stopped( ) is checked and the render ends early when it is true
+		template<typename Control>
+		inline void stream_to( daw::io::WriteProxy &writer, Control &control ) const {
+			stream_to_impl( writer, nullptr, control );
+		}
+
+		template<typename Control, typename T>
+		inline void stream_to( daw::io::WriteProxy &writer, Control &control, T &state ) const {
+			static_assert( not std::is_const_v<T>, "Only mutable state is supported" );
+			void *state_ptr = reinterpret_cast<void *>( std::addressof( state ) );
+			stream_to_impl( writer, state_ptr, control );
+		}
+
+		/// A profile with counters for each call, date, time, and timestamp tag of this template, for
+		/// use with profile_to
+		[[nodiscard]] render_profile make_profile( ) const {
+			auto tags = std::vector<render_profile::tag>( );
+			tags.reserve( m_call_sites.size( ) + m_time_parts.size( ) );
+			for( auto const &site : m_call_sites ) {
+				tags.push_back(
+				  render_profile::tag{ static_cast<std::string>( arena_view( site.name ) ), site.offset } );
+			}
+			for( auto const &part : m_time_parts ) {
+				tags.push_back( render_profile::tag{ time_tag_name( part.op ), part.offset } );
+			}
+			return render_profile( std::move( tags ) );
+		}
+
+		/// Render the template to writer as write_to does, recording the calls, latency, bytes
+		/// written, and errors of each call, date, time, and timestamp tag in profile.  profile must
+		/// come from make_profile on this template.  Renders through write_to and the other
+		/// members are not instrumented and pay nothing for this
+		inline void profile_to( daw::io::WriteProxy &writer, render_profile &profile ) const {
+			profile_to_impl( writer, nullptr, profile );
+		}
+
+		template<typename T>
+		inline void profile_to( daw::io::WriteProxy &writer, render_profile &profile, T &state ) const {
+			static_assert( not std::is_const_v<T>, "Only mutable state is supported" );
+			void *state_ptr = reinterpret_cast<void *>( std::addressof( state ) );
+			profile_to_impl( writer, state_ptr, profile );
+		}
+
+		/// Render the template, passing each run of literal text to on_literal and writing all other
+		/// output to writer.  The views passed to on_literal refer to the template's own storage and
+		/// are valid for as long as the parse_template is
+		template<typename OnLiteral>
+		inline void write_split_to( daw::io::WriteProxy &writer, OnLiteral &&on_literal ) const {
+			render_program( writer, nullptr, on_literal );
+		}
+
+		template<typename OnLiteral, typename T>
+		inline void
+		write_split_to( daw::io::WriteProxy &writer, OnLiteral &&on_literal, T &state ) const {
+			static_assert( not std::is_const_v<T>, "Only mutable state is supported" );
+			void *state_ptr = reinterpret_cast<void *>( std::addressof( state ) );
+			render_program( writer, state_ptr, on_literal );
+		}
+
+		/// The number of parts in the compiled template.  Together with render_part this lets a caller
+		/// step through a render and suspend between parts
+		[[nodiscard]] std::size_t part_count( ) const noexcept {
+			return m_program.size( );
+		}
+
+		/// Whether the template has <%if%> or <%each%> blocks
+		[[nodiscard]] bool has_block_tags( ) const noexcept {
+			return not m_block_sites.empty( );
+		}
+
+		/// Whether a call tag named name is inside a <%cache%>, <%if%>, or <%each%> block, and so is
+		/// rendered within the block's part rather than as a part of its own
+		[[nodiscard]] bool is_called_in_block( daw::string_view name ) const {
+			auto const pos = m_slot_lookup.find( name );
+			if( pos == m_slot_lookup.end( ) ) {
+				return false;
+			}
+			std::size_t depth = 0;
+			for( auto const &inst : m_program ) {
+				switch( inst.op ) {
+				case parse_template_impl::op_code::cache_begin:
+				case parse_template_impl::op_code::if_begin:
+				case parse_template_impl::op_code::each_begin:
+					++depth;
+					break;
+				case parse_template_impl::op_code::cache_end:
+				case parse_template_impl::op_code::if_end:
+				case parse_template_impl::op_code::each_end:
+					--depth;
+					break;
+				case parse_template_impl::op_code::call:
+					if( depth != 0 and m_call_sites[inst.index].slot == pos->second ) {
+						return true;
+					}
+					break;
+				default:
+					break;
+				}
+			}
+			return false;
+		}
+
+		/// The escaping of the output of part n, where n < part_count( ).  It is the call tag's escape
+		/// attribute, or the default escape, for a call tag and none for other parts
+		[[nodiscard]] escape_mode part_escape( std::size_t n ) const noexcept {
+			auto const &inst = m_program[n];
+			if( inst.op != parse_template_impl::op_code::call ) {
+				return escape_mode::none;
+			}
+			return m_call_sites[inst.index].escape.value_or( m_default_escape );
+		}
+
+		/// Render part n, where n < part_count( ), to writer and return the next part to render.
+		/// Starting at 0 and rendering the returned part until it is part_count( ) is the same as
+		/// write_to.  A <%cache%>, <%if%>, or <%each%> block is rendered as one part
+		inline std::size_t render_part( std::size_t n, daw::io::WriteProxy &writer ) const {
+			return render_part_impl( n, writer, nullptr );
+		}
+
+		template<typename T>
+		inline std::size_t render_part( std::size_t n, daw::io::WriteProxy &writer, T &state ) const {
+			static_assert( not std::is_const_v<T>, "Only mutable state is supported" );
+			return render_part_impl( n, writer, reinterpret_cast<void *>( std::addressof( state ) ) );
+		}
+
+		/// Use cache for the output of <%cache%> blocks.  A template that has cache blocks gets its
+		/// own cache, of fragment_cache::default_max_bytes, unless one is set.  Like adding
+		/// callbacks, this must not be called while rendering
+		void set_fragment_cache( std::shared_ptr<fragment_cache> cache ) {
+			if( not cache ) {
+				m_on_error( parse_template_error_types::precondition_violation,
+				            { },
+				            "A fragment cache is required" );
+			}
+			m_fragment_cache = std::move( cache );
+		}
+
+		/// The cache used for <%cache%> blocks, null when the template has none
+		[[nodiscard]] std::shared_ptr<fragment_cache> const &get_fragment_cache( ) const noexcept {
+			return m_fragment_cache;
+		}
+
+		template<typename... Args, typename Splitter>
+		static constexpr std::tuple<parse_template_impl::actual_type_t<Args>...>
+		parse_args_from_string( daw::string_view &sv, Splitter &&sp ) {
+			[[maybe_unused]] auto parse_value = [&]( daw::string_view &str, auto Tag ) {
+				auto part = str.pop_front_until( sp );
 				using daw::parser::converters::parse_to_value;
 				using parse_template_impl::parse_to_value;
 				return parse_to_value( part, Tag );
 			};
-			using tp_t = DAW_TYPEOF( std::forward_as_tuple( parse_value( sv, daw::tag<Args> )... ) );
 			// Order matters here, must be left to right as the string_view is state
-			return std::apply( cb, tp_t{ parse_value( sv, daw::tag<Args> )... } );
+			return std::tuple<parse_template_impl::actual_type_t<Args>...>{
+			  parse_value( sv, daw::tag<Args> )... };
+		}
+
+		template<typename... Args, typename Callback, typename Splitter>
+		constexpr decltype( auto )
+		apply_from_string( Callback &cb, daw::string_view sv, Splitter &&sp ) {
+			return std::apply( cb, parse_args_from_string<Args...>( sv, DAW_FWD( sp ) ) );
 		}
 
+		/// Bind callback to all call tags named name.  The arguments of each call tag are parsed
+		/// here, once, and any parse errors are reported now instead of during rendering
 		template<typename... ArgTypes, typename Callback>
 		void add_callback( daw::string_view name, Callback &&callback ) {
-			m_callbacks.insert_or_assign(
-			  static_cast<std::string>( name ),
-			  [&, callback = DAW_FWD( callback )]( daw::string_view str,
-			                                       daw::io::WriteProxy &writer,
-			                                       void *state ) mutable {
-				  auto cb =
-				    parse_template_impl::make_callback<ArgTypes...>( m_on_error, callback, writer, state );
-				  try {
-					  apply_from_string<ArgTypes...>( cb, str, ',' );
-				  } catch( std::exception const &ex ) {
-					  m_on_error( parse_template_error_types::parser_exception, str, ex.what( ) );
-				  } catch( ... ) {
-					  m_on_error( parse_template_error_types::parser_exception,
-					              str,
-					              "Exception while parsing" );
-				  }
-			  } );
+			auto pos = m_slot_lookup.find( name );
+			if( pos == m_slot_lookup.end( ) ) {
+				// The template does not use this callback
+				return;
+			}
+			auto &slot = m_slots[pos->second];
+			// Rendering is const and may happen on many threads at once, so callbacks are only ever
+			// invoked as const
+			auto cb = std::make_shared<std::decay_t<Callback> const>( DAW_FWD( callback ) );
+			for( auto site_idx : slot.call_sites ) {
+				auto &site = m_call_sites[site_idx];
+				site.invoke = bind_call_site<ArgTypes...>( cb, arena_view( site.args ) );
+			}
+			slot.is_bound = true;
+		}
+
+		/// Bind callback, whose output only depends on its arguments, to all call tags named name.
+		/// The callback is evaluated once for each distinct set of arguments and its output is
+		/// then written like literal text.  A value is evaluated again after ttl, unless ttl is zero,
+		/// and after the returned handle is invalidated.  Callbacks are passed no state
+		template<typename... ArgTypes, typename Callback>
+		pure_callback_handle add_pure_callback( daw::string_view name,
+		                                        Callback &&callback,
+		                                        std::chrono::seconds ttl = std::chrono::seconds( 0 ) ) {
+			auto handle = pure_callback_handle( );
+			add_pure_callback<ArgTypes...>( name, DAW_FWD( callback ), handle, ttl );
+			return handle;
+		}
+
+		/// As add_pure_callback, invalidated by handle
+		template<typename... ArgTypes, typename Callback>
+		void add_pure_callback( daw::string_view name,
+		                        Callback &&callback,
+		                        pure_callback_handle const &handle,
+		                        std::chrono::seconds ttl = std::chrono::seconds( 0 ) ) {
+			auto pos = m_slot_lookup.find( name );
+			if( pos == m_slot_lookup.end( ) ) {
+				return;
+			}
+			auto &slot = m_slots[pos->second];
+			auto cb = std::make_shared<std::decay_t<Callback> const>( DAW_FWD( callback ) );
+			// Call sites with the same arguments share their value
+			auto caches = std::map<daw::string_view, std::shared_ptr<parse_template_impl::pure_cache>>( );
+			for( auto site_idx : slot.call_sites ) {
+				auto &site = m_call_sites[site_idx];
+				auto const args = arena_view( site.args );
+				auto &cache = caches[args];
+				if( not cache ) {
+					cache = std::make_shared<parse_template_impl::pure_cache>( handle.generation( ), ttl );
+				}
+				site.invoke = bind_pure_site( bind_call_site<ArgTypes...>( cb, args ), cache );
+			}
+			slot.is_bound = true;
+		}
+
+		/// Ensure that every callback used by the template has been added.  Any missing callbacks are
+		/// reported once, here, so that rendering does not need to check each call.  This is called
+		/// on the first render if it has not been called prior
+		void finalize( ) {
+			check_bindings( );
+		}
+
+		[[nodiscard]] bool is_finalized( ) const noexcept {
+			return m_is_finalized.load( std::memory_order_acquire );
 		}
 
 		template<typename StateType, typename... ArgTypes, typename Callback>
@@ -546,6 +1379,43 @@ namespace daw {
 			    DAW_FWD( callback ) ) );
 		}
 
+		/// Bind callback to all if and each tags named name.  For an if, the result is tested.  For an
+		/// each, the result is either the number of times to render the block, or a range whose
+		/// elements are each passed as the state of one render of the block.  Tags inside an each
+		/// over a range are passed the element as their state, so callbacks expecting the render's
+		/// state must not be called inside it.  A result that no block can use is a compile error,
+		/// one that only the other kind of block can use is reported here
+		template<typename... ArgTypes, typename Callback>
+		void add_block_callback( daw::string_view name, Callback &&callback ) {
+			auto cb = std::make_shared<std::decay_t<Callback> const>( DAW_FWD( callback ) );
+			bind_block_sites<ArgTypes...>( name,
+			                               [cb]( void *, auto const &args ) -> decltype( auto ) {
+				                               return std::apply( *cb, args );
+			                               } );
+		}
+
+		template<typename StateType, typename... ArgTypes, typename Callback>
+		void add_stateful_block_callback( daw::string_view name, Callback &&callback ) {
+			static_assert( not std::is_const_v<std::remove_reference_t<StateType>>,
+			               "Only mutable state is supported" );
+			using state_t = std::remove_reference_t<StateType>;
+			auto cb = std::make_shared<std::decay_t<Callback> const>( DAW_FWD( callback ) );
+			bind_block_sites<ArgTypes...>(
+			  name,
+			  [on_error = m_on_error, cb]( void *state, auto const &args ) -> decltype( auto ) {
+				  if( not state ) {
+					  on_error( parse_template_error_types::unknown_tag,
+					            daw::string_view{ },
+					            "Stateful function expects state param on write_to/to_string call" );
+				  }
+				  return std::apply(
+				    [&]( auto const &...as ) -> decltype( auto ) {
+					    return ( *cb )( as..., *reinterpret_cast<state_t *>( state ) );
+				    },
+				    args );
+			  } );
+		}
+
 		void process_timestamp_tag( string_view tag ) {
 			static char const default_ts_fmt[] = "%Y-%m-%dT%T%z";
 			auto args = parse_template_impl::find_split_args( m_on_error, tag );
@@ -555,55 +1425,60 @@ namespace daw {
 				            "Unexpected argument count" );
 			}
 
-			auto const ts_fmt = static_cast<std::string>( [&]( ) {
+			auto const ts_fmt = [&]( ) {
 				if( args.empty( ) or args[0].empty( ) ) {
 					return daw::string_view{ default_ts_fmt };
 				}
 				return args[0];
-			}( ) );
-
-			auto const tz = [&]( ) {
-				if( args.size( ) < 2 or args[1].empty( ) ) {
-					return date::current_zone( );
-				}
-				return date::locate_zone( static_cast<std::string_view>( args[1] ) );
 			}( );
 
-			m_doc_builder.emplace_back( [&, ts_fmt, tz]( daw::io::WriteProxy &writer ) {
-				using namespace date;
-				using namespace std::chrono;
-
-				std::stringstream ss{ };
-
-				auto current_time = make_zoned( tz, floor<seconds>( std::chrono::system_clock::now( ) ) );
-				ss << format( ts_fmt, current_time );
+			auto const &zone =
+			  parse_template_impl::resolve_zone( args.size( ) < 2 ? daw::string_view( ) : args[1] );
 
-				auto ret = writer.write( ss.str( ) );
-
-				if( ret.status != io::IOOpStatus::Ok ) {
-					m_on_error( parse_template_error_types::io_error, ss.str( ), "Error writing to output" );
-				}
-			} );
+			add_time_part( parse_template_impl::op_code::timestamp, zone, ts_fmt );
 		}
 
 	private:
-		void process_template( daw::string_view template_str ) {
-			process_text( template_str.pop_front_until( "<%" ) );
+		void process_template( daw::string_view template_str,
+		                       include_resolver const *resolve_include ) {
+			using parse_template_impl::pop_front_until_pair;
+			// Literal text and tag arguments come from the template, so this is usually all the arena
+			// will need
+			m_arena.reserve( m_arena.size( ) + template_str.size( ) );
+			auto const *const source_first = template_str.data( );
+			process_text( pop_front_until_pair( template_str, '<', '%' ) );
 			while( not template_str.empty( ) ) {
-				auto item = template_str.pop_front_until( "%>" );
-				if( template_str.empty( ) ) {
+				auto const tag_end = parse_template_impl::find_pair( template_str, '%', '>' );
+				if( tag_end == daw::string_view::npos ) {
 					m_on_error( parse_template_error_types::empty_tag, template_str, "Unexpected empty tag" );
 				}
-				parse_tag( item );
-				process_text( template_str.pop_front_until( "<%" ) );
+				// The offset of the opening <%
+				m_tag_offset = static_cast<std::size_t>( template_str.data( ) - source_first ) - 2;
+				parse_tag( template_str.substr( 0, tag_end ), resolve_include );
+				template_str.remove_prefix( tag_end + 2 );
+				process_text( pop_front_until_pair( template_str, '<', '%' ) );
+			}
+			if( not m_open_blocks.empty( ) ) {
+				switch( m_open_blocks.back( ).op ) {
+				case parse_template_impl::op_code::cache_begin:
+					m_on_error( parse_template_error_types::missing_tag, { }, "Missing <%endcache%>" );
+				case parse_template_impl::op_code::if_begin:
+					m_on_error( parse_template_error_types::missing_tag, { }, "Missing <%endif%>" );
+				default:
+					m_on_error( parse_template_error_types::missing_tag, { }, "Missing <%endeach%>" );
+				}
 			}
 		}
 
-		void parse_tag( daw::string_view tag ) {
+		void parse_tag( daw::string_view tag, include_resolver const *resolve_include ) {
 			using namespace daw::string_view_literals;
 
 			parse_template_impl::remove_leading_whitespace( tag );
 
+			if( tag.starts_with( "cache" ) ) {
+				tag.remove_prefix( "cache"_sv.size( ) );
+				return process_cache_tag( tag );
+			}
 			if( tag.starts_with( "call" ) ) {
 				tag.remove_prefix( "call"_sv.size( ) );
 				return process_call_tag( tag );
@@ -612,6 +1487,36 @@ namespace daw {
 				tag.remove_prefix( "date"_sv.size( ) );
 				return process_date_tag( tag );
 			}
+			if( tag.starts_with( "each" ) ) {
+				tag.remove_prefix( "each"_sv.size( ) );
+				return process_block_tag( tag, parse_template_impl::op_code::each_begin );
+			}
+			if( tag.starts_with( "else" ) ) {
+				return process_else_tag( tag );
+			}
+			if( tag.starts_with( "endcache" ) ) {
+				return process_endcache_tag( tag );
+			}
+			if( tag.starts_with( "endeach" ) ) {
+				return process_endeach_tag( tag );
+			}
+			if( tag.starts_with( "endif" ) ) {
+				return process_endif_tag( tag );
+			}
+			if( tag.starts_with( "if" ) ) {
+				tag.remove_prefix( "if"_sv.size( ) );
+				return process_block_tag( tag, parse_template_impl::op_code::if_begin );
+			}
+			if( tag.starts_with( "include" ) ) {
+				tag.remove_prefix( "include"_sv.size( ) );
+				return process_include_tag( tag, resolve_include );
+			}
+			if( tag.starts_with( "flush" ) ) {
+				// Only streaming renders act on a flush, it outputs nothing
+				m_program.push_back(
+				  parse_template_impl::instruction{ parse_template_impl::op_code::flush, 0 } );
+				return;
+			}
 			if( tag.starts_with( "time" ) ) {
 				if( tag.starts_with( "timestamp" ) ) {
 					tag.remove_prefix( "timestamp"_sv.size( ) );
@@ -625,35 +1530,591 @@ namespace daw {
 			}
 		}
 
-		void process_call_tag( daw::string_view tag ) {
-			using namespace daw::string_view_literals;
+		void process_cache_tag( daw::string_view tag ) {
+			auto args = parse_template_impl::find_split_args( m_on_error, tag );
+			if( args.empty( ) or args.size( ) > 2 ) {
+				m_on_error( parse_template_error_types::unexpected_arg_count,
+				            tag,
+				            "Unexpected argument count" );
+			}
+			if( args[0].empty( ) ) {
+				m_on_error( parse_template_error_types::missing_tag,
+				            tag,
+				            "Invalid cache key, cannot be empty" );
+			}
+			// An empty ttl, as in "key,", is an error rather than no ttl
+			auto const arg_text = parse_template_impl::find_args( m_on_error, tag );
+			if( ( args.size( ) == 2 and args[1].empty( ) ) or
+			    ( not arg_text.empty( ) and arg_text.back( ) == ',' ) ) {
+				m_on_error( parse_template_error_types::parser_exception,
+				            tag,
+				            "Invalid cache ttl, expected seconds" );
+			}
+			auto ttl = std::int64_t{ 0 };
+			if( args.size( ) == 2 ) {
+				for( char c : args[1] ) {
+					if( c < '0' or c > '9' or ttl > std::numeric_limits<std::int32_t>::max( ) ) {
+						m_on_error( parse_template_error_types::parser_exception,
+						            args[1],
+						            "Invalid cache ttl, expected seconds" );
+					}
+					ttl = ttl * 10 + ( c - '0' );
+				}
+			}
+			open_cache_block( args[0], std::chrono::seconds( ttl ) );
+		}
+
+		/// The key of a cache block is fixed text, so a cache block inside an each block would
+		/// replay the first item's output for every item
+		void open_cache_block( daw::string_view key, std::chrono::seconds ttl ) {
+			for( auto const &open : m_open_blocks ) {
+				if( open.op == parse_template_impl::op_code::each_begin ) {
+					m_on_error( parse_template_error_types::unknown_tag,
+					            key,
+					            "A <%cache%> block cannot be inside an <%each%> block" );
+				}
+			}
+			if( not m_fragment_cache ) {
+				m_fragment_cache = std::make_shared<fragment_cache>( );
+			}
+			auto const block_idx = m_cache_blocks.size( );
+			m_cache_blocks.push_back(
+			  parse_template_impl::cache_block{ append_to_arena( key ), ttl } );
+			open_block( parse_template_impl::op_code::cache_begin, block_idx );
+		}
+
+		void process_endcache_tag( daw::string_view tag ) {
+			auto const block_idx = close_block( tag,
+			                                    parse_template_impl::op_code::cache_begin,
+			                                    parse_template_impl::op_code::cache_end,
+			                                    "<%endcache%> without a matching <%cache%>" );
+			m_cache_blocks[block_idx].end = m_program.size( ) - 1;
+		}
+
+		/// Start a block whose begin instruction is op, it is ended by close_block
+		void open_block( parse_template_impl::op_code op, std::size_t index ) {
+			auto const inst = parse_template_impl::instruction{ op, static_cast<std::uint32_t>( index ) };
+			m_open_blocks.push_back( inst );
+			m_program.push_back( inst );
+		}
+
+		/// End the innermost open block, which must have been started by begin, with an end
+		/// instruction.  Returns the index of the block
+		std::size_t close_block( daw::string_view tag,
+		                         parse_template_impl::op_code begin,
+		                         parse_template_impl::op_code end,
+		                         daw::string_view message ) {
+			if( m_open_blocks.empty( ) or m_open_blocks.back( ).op != begin ) {
+				m_on_error( parse_template_error_types::unknown_tag, tag, message );
+			}
+			auto const index = m_open_blocks.back( ).index;
+			m_open_blocks.pop_back( );
+			m_program.push_back( parse_template_impl::instruction{ end, index } );
+			return index;
+		}
+
+		void process_block_tag( daw::string_view tag, parse_template_impl::op_code op ) {
 			tag = parse_template_impl::find_args( m_on_error, tag );
 			if( tag.empty( ) ) {
 				m_on_error( parse_template_error_types::missing_tag,
 				            tag.data( ),
-				            "Could not find start of call args" );
+				            "Could not find start of block args" );
 			}
 			auto callable_name = tag.pop_front_until( "," );
+			if( callable_name.empty( ) ) {
+				m_on_error( parse_template_error_types::missing_tag,
+				            callable_name.data( ),
+				            "Invalid block callback name, cannot be empty" );
+			}
+			add_block_site( op, callable_name, tag );
+		}
+
+		void add_block_site( parse_template_impl::op_code op,
+		                     daw::string_view callable_name,
+		                     daw::string_view args ) {
+			// The callback is bound, and the arguments parsed, when add_block_callback is called
+			auto const site_idx = m_block_sites.size( );
+			auto const slot_idx = get_slot( callable_name );
+			m_block_sites.push_back( parse_template_impl::block_site{ append_to_arena( callable_name ),
+			                                                          append_to_arena( args ),
+			                                                          slot_idx,
+			                                                          m_program.size( ) } );
+			m_slots[slot_idx].block_sites.push_back( site_idx );
+			open_block( op, site_idx );
+		}
+
+		void process_else_tag( daw::string_view tag ) {
+			if( m_open_blocks.empty( ) or
+			    m_open_blocks.back( ).op != parse_template_impl::op_code::if_begin or
+			    m_block_sites[m_open_blocks.back( ).index].else_pos != 0 ) {
+				m_on_error( parse_template_error_types::unknown_tag,
+				            tag,
+				            "<%else%> without a matching <%if%>" );
+			}
+			auto const site_idx = m_open_blocks.back( ).index;
+			m_block_sites[site_idx].else_pos = m_program.size( );
+			m_program.push_back(
+			  parse_template_impl::instruction{ parse_template_impl::op_code::if_else, site_idx } );
+		}
+
+		void process_endif_tag( daw::string_view tag ) {
+			auto const site_idx = close_block( tag,
+			                                   parse_template_impl::op_code::if_begin,
+			                                   parse_template_impl::op_code::if_end,
+			                                   "<%endif%> without a matching <%if%>" );
+			auto &site = m_block_sites[site_idx];
+			site.end = m_program.size( ) - 1;
+			if( site.else_pos == 0 ) {
+				site.else_pos = site.end;
+			}
+		}
+
+		void process_endeach_tag( daw::string_view tag ) {
+			auto const site_idx = close_block( tag,
+			                                   parse_template_impl::op_code::each_begin,
+			                                   parse_template_impl::op_code::each_end,
+			                                   "<%endeach%> without a matching <%each%>" );
+			auto &site = m_block_sites[site_idx];
+			site.end = m_program.size( ) - 1;
+			site.else_pos = site.end;
+		}
+
+		void process_include_tag( daw::string_view tag, include_resolver const *resolve_include ) {
+			auto args = parse_template_impl::find_split_args( m_on_error, tag );
+			if( args.size( ) != 1 or args[0].empty( ) ) {
+				m_on_error( parse_template_error_types::unexpected_arg_count,
+				            tag,
+				            "Expected the name of the template to include" );
+			}
+			auto const *included = resolve_include ? ( *resolve_include )( args[0] ) : nullptr;
+			if( not included ) {
+				m_on_error( parse_template_error_types::unknown_include,
+				            args[0],
+				            "Attempt to include an unknown template: " +
+				              static_cast<std::string>( args[0] ) );
+			}
+			splice_template( *included );
+		}
+
+		/// Append the parts of other as if its text had been in this template.  Literal text is
+		/// merged with the text around it and call tags become this template's call sites
+		void splice_template( parse_template const &other ) {
+			for( auto const &inst : other.m_program ) {
+				switch( inst.op ) {
+				case parse_template_impl::op_code::raw_text:
+					process_text(
+					  other.arena_view( parse_template_impl::text_ref{ inst.index, inst.size } ) );
+					break;
+				case parse_template_impl::op_code::call: {
+					auto const &site = other.m_call_sites[inst.index];
+					m_tag_offset = site.offset;
+					add_call_site( other.arena_view( site.name ),
+					               other.arena_view( site.args ),
+					               site.escape );
+					break;
+				}
+				case parse_template_impl::op_code::date:
+				case parse_template_impl::op_code::time:
+				case parse_template_impl::op_code::timestamp: {
+					auto const &part = other.m_time_parts[inst.index];
+					m_tag_offset = part.offset;
+					add_time_part( inst.op, *part.zone, other.arena_view( part.fmt ) );
+					break;
+				}
+				case parse_template_impl::op_code::flush:
+					m_program.push_back( inst );
+					break;
+				case parse_template_impl::op_code::cache_begin: {
+					auto const &block = other.m_cache_blocks[inst.index];
+					open_cache_block( other.arena_view( block.key ), block.ttl );
+					break;
+				}
+				case parse_template_impl::op_code::cache_end:
+					process_endcache_tag( { } );
+					break;
+				case parse_template_impl::op_code::if_begin:
+				case parse_template_impl::op_code::each_begin: {
+					auto const &site = other.m_block_sites[inst.index];
+					add_block_site( inst.op, other.arena_view( site.name ), other.arena_view( site.args ) );
+					break;
+				}
+				case parse_template_impl::op_code::if_else:
+					process_else_tag( { } );
+					break;
+				case parse_template_impl::op_code::if_end:
+					process_endif_tag( { } );
+					break;
+				case parse_template_impl::op_code::each_end:
+					process_endeach_tag( { } );
+					break;
+				}
+			}
+		}
+
+		/// Add the parts in image as splice_template does for a compiled template.  The image is
+		/// checked as it is loaded, so that a damaged image cannot make rendering read out of bounds
+		void load_image( daw::string_view image ) {
+			auto header = parse_template_impl::image_header{ };
+			if( auto const error = parse_template_impl::read_image_header( image, header );
+			    not error.empty( ) ) {
+				m_on_error( parse_template_error_types::invalid_image, { }, error );
+			}
+			if( header.default_escape > static_cast<std::uint8_t>( escape_mode::json ) ) {
+				m_on_error( parse_template_error_types::invalid_image, { }, "Invalid default escape" );
+			}
+			m_default_escape = static_cast<escape_mode>( header.default_escape );
+			auto const text = parse_template_impl::read_image_text( image, header );
+			auto const text_at = [&]( parse_template_impl::image_text ref ) {
+				if( std::uint64_t{ ref.first } + ref.size > text.size( ) ) {
+					m_on_error( parse_template_error_types::invalid_image,
+					            { },
+					            "Template image text is out of range" );
+				}
+				return text.substr( ref.first, ref.size );
+			};
+			auto const zone_for = [&]( daw::string_view name ) -> auto const & {
+				try {
+					return parse_template_impl::resolve_zone( name );
+				} catch( std::exception const &ex ) {
+					m_on_error( parse_template_error_types::invalid_image, name, ex.what( ) );
+				}
+			};
+			auto const expect_open = [&]( parse_template_impl::op_code begin ) {
+				if( m_open_blocks.empty( ) or m_open_blocks.back( ).op != begin ) {
+					m_on_error( parse_template_error_types::invalid_image,
+					            { },
+					            "Template image has a block end without a matching begin" );
+				}
+			};
+			m_arena.reserve( header.text_size );
+			m_program.reserve( header.record_count );
+			for( std::size_t n = 0; n < header.record_count; ++n ) {
+				auto const record = parse_template_impl::read_image_record( image, n );
+				auto const op = static_cast<parse_template_impl::op_code>( record.op );
+				switch( op ) {
+				case parse_template_impl::op_code::raw_text:
+					process_text( text_at( record.first ) );
+					break;
+				case parse_template_impl::op_code::call: {
+					if( record.escape > static_cast<std::uint8_t>( escape_mode::json ) + 1 ) {
+						m_on_error( parse_template_error_types::invalid_image, { }, "Invalid escape" );
+					}
+					auto escape = std::optional<escape_mode>( );
+					if( record.escape != 0 ) {
+						escape = static_cast<escape_mode>( record.escape - 1 );
+					}
+					m_tag_offset = static_cast<std::size_t>( record.value );
+					add_call_site( text_at( record.first ), text_at( record.second ), escape );
+					break;
+				}
+				case parse_template_impl::op_code::date:
+				case parse_template_impl::op_code::time:
+				case parse_template_impl::op_code::timestamp:
+					m_tag_offset = static_cast<std::size_t>( record.value );
+					add_time_part( op, zone_for( text_at( record.first ) ), text_at( record.second ) );
+					break;
+				case parse_template_impl::op_code::flush:
+					m_program.push_back(
+					  parse_template_impl::instruction{ parse_template_impl::op_code::flush, 0 } );
+					break;
+				case parse_template_impl::op_code::cache_begin:
+					if( record.value >
+					    static_cast<std::uint64_t>( std::numeric_limits<std::int32_t>::max( ) ) ) {
+						m_on_error( parse_template_error_types::invalid_image, { }, "Invalid cache ttl" );
+					}
+					open_cache_block( text_at( record.first ),
+					                  std::chrono::seconds( static_cast<std::int64_t>( record.value ) ) );
+					break;
+				case parse_template_impl::op_code::cache_end:
+					expect_open( parse_template_impl::op_code::cache_begin );
+					process_endcache_tag( { } );
+					break;
+				case parse_template_impl::op_code::if_begin:
+				case parse_template_impl::op_code::each_begin:
+					add_block_site( op, text_at( record.first ), text_at( record.second ) );
+					break;
+				case parse_template_impl::op_code::if_else:
+					expect_open( parse_template_impl::op_code::if_begin );
+					if( m_block_sites[m_open_blocks.back( ).index].else_pos != 0 ) {
+						m_on_error( parse_template_error_types::invalid_image,
+						            { },
+						            "Template image has a second else in an if block" );
+					}
+					process_else_tag( { } );
+					break;
+				case parse_template_impl::op_code::if_end:
+					expect_open( parse_template_impl::op_code::if_begin );
+					process_endif_tag( { } );
+					break;
+				case parse_template_impl::op_code::each_end:
+					expect_open( parse_template_impl::op_code::each_begin );
+					process_endeach_tag( { } );
+					break;
+				default:
+					m_on_error( parse_template_error_types::invalid_image,
+					            { },
+					            "Template image has an unknown instruction" );
+				}
+			}
+			if( not m_open_blocks.empty( ) ) {
+				m_on_error( parse_template_error_types::invalid_image,
+				            { },
+				            "Template image has a block without an end" );
+			}
+		}
+
+		void process_call_tag( daw::string_view tag ) {
+			using namespace daw::string_view_literals;
+			auto args = parse_template_impl::find_args( m_on_error, tag );
+			if( args.empty( ) ) {
+				m_on_error( parse_template_error_types::missing_tag,
+				            args.data( ),
+				            "Could not find start of call args" );
+			}
+			auto const escape = find_call_escape( tag, args );
+			auto callable_name = args.pop_front_until( "," );
 			if( callable_name.empty( ) ) {
 				m_on_error( parse_template_error_types::missing_tag,
 				            callable_name.data( ),
 				            "Invalid call name, cannot be empty" );
 			}
+			add_call_site( callable_name, args, escape );
+		}
 
-			// This ensures that a lookup will always success when processing but the callback may not be
-			// set
-			m_callbacks[static_cast<std::string>( callable_name )] = nullptr;
+		/// The escape attribute of the call tag tag, args is the value of its args attribute
+		std::optional<escape_mode> find_call_escape( daw::string_view tag, daw::string_view args ) {
+			// Skip the args attribute, as its value is text that could contain escape="
+			auto const args_first = static_cast<std::size_t>( args.data( ) - tag.data( ) );
+			auto value = parse_template_impl::find_escape_attribute( m_on_error,
+			                                                         tag.substr( 0, args_first ) );
+			if( not value ) {
+				value = parse_template_impl::find_escape_attribute(
+				  m_on_error,
+				  tag.substr( args_first + args.size( ) + 1 ) );
+			}
+			if( not value ) {
+				return std::nullopt;
+			}
+			auto const escape = parse_template_impl::parse_escape_mode( *value );
+			if( not escape ) {
+				m_on_error( parse_template_error_types::unknown_escape,
+				            *value,
+				            "Unknown escape, expected one of html, attr, url, json, or none" );
+			}
+			return escape;
+		}
 
-			m_doc_builder.emplace_back(
-			  [callable_name, tag, this]( daw::io::WriteProxy &writer, void *state ) {
-				  auto &cb = m_callbacks.find( callable_name )->second;
-				  if( not cb ) {
-					  m_on_error( parse_template_error_types::unknown_function,
-					              callable_name.data( ),
-					              "Attempt to call an undefined function" );
-				  }
-				  cb( tag, writer, state );
-			  } );
+		void add_call_site( daw::string_view callable_name,
+		                    daw::string_view args,
+		                    std::optional<escape_mode> escape ) {
+			// The callback is bound, and the arguments parsed, when add_callback is called for this name
+			auto const site_idx = m_call_sites.size( );
+			auto const slot_idx = get_slot( callable_name );
+			m_call_sites.push_back( parse_template_impl::call_site{ append_to_arena( callable_name ),
+			                                                        append_to_arena( args ),
+			                                                        slot_idx,
+			                                                        m_tag_offset,
+			                                                        escape } );
+			m_slots[slot_idx].call_sites.push_back( site_idx );
+			m_dynamic_size_estimate += parse_template_impl::call_size_estimate;
+			m_program.push_back( parse_template_impl::instruction{
+			  parse_template_impl::op_code::call, static_cast<std::uint32_t>( site_idx ) } );
+		}
+
+		std::size_t get_slot( daw::string_view name ) {
+			auto pos = m_slot_lookup.find( name );
+			if( pos != m_slot_lookup.end( ) ) {
+				return pos->second;
+			}
+			auto const slot_idx = m_slots.size( );
+			auto const &key =
+			  m_slot_lookup.emplace( static_cast<std::string>( name ), slot_idx ).first->first;
+			// The name refers to the key as map nodes are stable
+			m_slots.push_back( parse_template_impl::callback_slot{ key } );
+			return slot_idx;
+		}
+
+		template<typename... ArgTypes, typename Callback>
+		std::function<void( daw::io::WriteProxy &, void *, escape_mode )>
+		bind_call_site( std::shared_ptr<Callback> const &cb, daw::string_view args ) {
+			auto parsed_args = parse_site_args<ArgTypes...>( args );
+			if constexpr( parse_template_impl::is_callback_invocable_v<
+			                Callback,
+			                parse_template_impl::arg_ref_type_t<ArgTypes>...> ) {
+				// Rendering does not copy the parsed arguments
+				return bind_parsed_args<parse_template_impl::arg_ref_type_t<ArgTypes>...>(
+				  cb,
+				  std::move( parsed_args ) );
+			} else {
+				return bind_parsed_args<ArgTypes...>( cb, std::move( parsed_args ) );
+			}
+		}
+
+		template<typename... CallArgs, typename Callback, typename ParsedArgs>
+		std::function<void( daw::io::WriteProxy &, void *, escape_mode )>
+		bind_parsed_args( std::shared_ptr<Callback> const &cb, ParsedArgs parsed_args ) {
+			return [on_error = m_on_error, cb, parsed_args = std::move( parsed_args )](
+			         daw::io::WriteProxy &writer, void *state, escape_mode escape ) {
+				auto f =
+				  parse_template_impl::make_callback<CallArgs...>( on_error, *cb, writer, state, escape );
+				std::apply( f, parsed_args );
+			};
+		}
+
+		/// Write the cached value of a pure callback, evaluating it with invoke when there is none or
+		/// it is out of date.  Concurrent renders that find it out of date each evaluate it
+		std::function<void( daw::io::WriteProxy &, void *, escape_mode )>
+		bind_pure_site( std::function<void( daw::io::WriteProxy &, void *, escape_mode )> invoke,
+		                std::shared_ptr<parse_template_impl::pure_cache> cache ) {
+			return [on_error = m_on_error, invoke = std::move( invoke ), cache = std::move( cache )](
+			         daw::io::WriteProxy &writer, void *, escape_mode escape ) {
+				using clock_t = std::chrono::steady_clock;
+				auto value = cache->value.load( );
+				auto const generation = cache->generation->load( std::memory_order_acquire );
+				if( DAW_UNLIKELY( not value or value->generation != generation or
+				                  ( cache->ttl.count( ) != 0 and clock_t::now( ) >= value->expires ) ) ) {
+					auto text = std::string( );
+					auto text_writer = daw::io::WriteProxy( text );
+					invoke( text_writer, nullptr, escape_mode::none );
+					auto const expires = cache->ttl.count( ) != 0 ? clock_t::now( ) + cache->ttl
+					                                               : clock_t::time_point::max( );
+					value = std::make_shared<parse_template_impl::pure_value const>(
+					  parse_template_impl::pure_value{ std::move( text ), generation, expires } );
+					cache->value.store( value );
+				}
+				auto const wret = parse_template_impl::write_output( writer, value->text, escape );
+				if( DAW_UNLIKELY( wret.status != daw::io::IOOpStatus::Ok ) ) {
+					on_error( parse_template_error_types::io_error,
+					          value->text,
+					          "Error writing to output" );
+				}
+			};
+		}
+
+		/// Parse the arguments of a call or block tag, reporting errors now instead of when rendering
+		template<typename... ArgTypes>
+		std::tuple<parse_template_impl::actual_type_t<ArgTypes>...>
+		parse_site_args( daw::string_view args ) {
+			using args_t = std::tuple<parse_template_impl::actual_type_t<ArgTypes>...>;
+			auto remaining = args;
+			auto parsed_args = [&]( ) -> args_t {
+				try {
+					return parse_args_from_string<ArgTypes...>( remaining, ',' );
+				} catch( std::exception const &ex ) {
+					m_on_error( parse_template_error_types::parser_exception, args, ex.what( ) );
+				} catch( ... ) {
+					m_on_error( parse_template_error_types::parser_exception,
+					            args,
+					            "Exception while parsing" );
+				}
+			}( );
+			if( not remaining.empty( ) ) {
+				m_on_error( parse_template_error_types::unexpected_arg_count,
+				            args,
+				            "Unexpected argument count" );
+			}
+			return parsed_args;
+		}
+
+		template<typename... ArgTypes, typename Invoker>
+		void bind_block_sites( daw::string_view name, Invoker const &invoker ) {
+			auto pos = m_slot_lookup.find( name );
+			if( pos == m_slot_lookup.end( ) ) {
+				// The template does not use this callback
+				return;
+			}
+			auto &slot = m_slots[pos->second];
+			for( auto site_idx : slot.block_sites ) {
+				auto &site = m_block_sites[site_idx];
+				auto args = parse_site_args<ArgTypes...>( arena_view( site.args ) );
+				if( m_program[site.begin].op == parse_template_impl::op_code::if_begin ) {
+					site.test = make_block_test( invoker, std::move( args ), slot.name );
+				} else {
+					site.loop = make_block_loop( invoker, std::move( args ), slot.name );
+				}
+			}
+			slot.blocks_bound = true;
+		}
+
+		template<typename Invoker, typename Args>
+		std::function<bool( void * )>
+		make_block_test( Invoker const &invoker, Args args, daw::string_view name ) {
+			using result_t = decltype( invoker( nullptr, args ) );
+			if constexpr( std::is_constructible_v<bool, result_t> ) {
+				return [on_error = m_on_error, invoker, args = std::move( args )]( void *state ) {
+					return static_cast<bool>( call_block_callback(
+					  on_error,
+					  [&]( ) -> decltype( auto ) { return invoker( state, args ); } ) );
+				};
+			} else {
+				// Which tags use the callback is only known from the template text, so a result that an
+				// <%each%> can use is reported here only if it names an <%if%>
+				using value_t = std::remove_cv_t<std::remove_reference_t<result_t>>;
+				static_assert( std::is_integral_v<value_t> or parse_template_impl::is_range_v<result_t>,
+				               "An <%if%> callback must return a value that converts to bool" );
+				m_on_error( parse_template_error_types::unknown_function,
+				            name,
+				            "An <%if%> callback must return a value that converts to bool" );
+			}
+		}
+
+		template<typename Invoker, typename Args>
+		std::function<void( void *, parse_template_impl::block_body const & )>
+		make_block_loop( Invoker const &invoker, Args args, daw::string_view name ) {
+			using result_t = decltype( invoker( nullptr, args ) );
+			using value_t = std::remove_cv_t<std::remove_reference_t<result_t>>;
+			if constexpr( std::is_integral_v<value_t> ) {
+				return [on_error = m_on_error, invoker, args = std::move( args )](
+				         void *state,
+				         parse_template_impl::block_body const &body ) {
+					auto const count =
+					  call_block_callback( on_error, [&] { return invoker( state, args ); } );
+					if constexpr( std::is_signed_v<value_t> ) {
+						if( count <= 0 ) {
+							return;
+						}
+					}
+					for( auto n = static_cast<std::uintmax_t>( count ); n > 0; --n ) {
+						body( state );
+					}
+				};
+			} else if constexpr( parse_template_impl::is_range_v<result_t> ) {
+				return [on_error = m_on_error, invoker, args = std::move( args )](
+				         void *state,
+				         parse_template_impl::block_body const &body ) {
+					auto &&range = call_block_callback(
+					  on_error,
+					  [&]( ) -> decltype( auto ) { return invoker( state, args ); } );
+					for( auto &item : range ) {
+						static_assert( not std::is_const_v<std::remove_reference_t<decltype( item )>>,
+						               "Only mutable state is supported, the elements of an each range are "
+						               "the state of its block" );
+						body( reinterpret_cast<void *>( std::addressof( item ) ) );
+					}
+				};
+			} else {
+				static_assert( std::is_constructible_v<bool, result_t>,
+				               "An <%each%> callback must return a count or a range" );
+				m_on_error( parse_template_error_types::unknown_function,
+				            name,
+				            "An <%each%> callback must return a count or a range" );
+			}
+		}
+
+		/// Call an if or each callback, reporting exceptions as other callbacks do
+		template<typename Func>
+		static decltype( auto )
+		call_block_callback( parse_template_impl::ErrorWrapper<ErrorHandler> const &on_error,
+		                     Func &&func ) {
+			try {
+				return func( );
+			} catch( std::exception const &ex ) {
+				on_error( parse_template_error_types::callback_exception, { }, ex.what( ) );
+			} catch( ... ) {
+				on_error( parse_template_error_types::callback_exception,
+				          { },
+				          "Exception while calling callback" );
+			}
 		}
 
 		void process_date_tag( daw::string_view str ) {
@@ -663,13 +2124,9 @@ namespace daw {
 				            str,
 				            "Unexpected argument count" );
 			}
-			auto const tz = [&]( ) {
-				if( args.empty( ) or args[0].empty( ) ) {
-					return date::current_zone( );
-				}
-				return date::locate_zone( static_cast<std::string>( args[0] ).c_str( ) );
-			}( );
-			m_doc_builder.emplace_back( parse_template_impl::date_tag_func( m_on_error, tz ) );
+			auto const &zone =
+			  parse_template_impl::resolve_zone( args.empty( ) ? daw::string_view( ) : args[0] );
+			add_time_part( parse_template_impl::op_code::date, zone, "%Y-%m-%d" );
 		}
 
 		void process_time_tag( daw::string_view str ) {
@@ -679,34 +2136,319 @@ namespace daw {
 				            str,
 				            "Unexpected argument count" );
 			}
-			auto const tz = [&]( ) {
-				if( args.empty( ) or args[0].empty( ) ) {
-					return date::current_zone( );
+			auto const &zone =
+			  parse_template_impl::resolve_zone( args.empty( ) ? daw::string_view( ) : args[0] );
+			add_time_part( parse_template_impl::op_code::time, zone, "%T" );
+		}
+
+		void add_time_part( parse_template_impl::op_code op,
+		                    parse_template_impl::resolved_zone const &zone,
+		                    daw::string_view fmt ) {
+			auto const part_idx = m_time_parts.size( );
+			auto const fmt_ref = append_to_arena( fmt );
+			m_time_parts.push_back( parse_template_impl::time_part{
+			  &zone,
+			  fmt_ref,
+			  &parse_template_impl::get_timestamp_cache( zone, fmt ),
+			  m_tag_offset,
+			  op } );
+			switch( op ) {
+			case parse_template_impl::op_code::date:
+				m_dynamic_size_estimate += parse_template_impl::date_size_estimate;
+				break;
+			case parse_template_impl::op_code::time:
+				m_dynamic_size_estimate += parse_template_impl::time_size_estimate;
+				break;
+			default:
+				m_dynamic_size_estimate += parse_template_impl::timestamp_size_estimate( fmt );
+				break;
+			}
+			m_program.push_back(
+			  parse_template_impl::instruction{ op, static_cast<std::uint32_t>( part_idx ) } );
+		}
+
+		void process_text( daw::string_view str ) {
+			if( str.empty( ) ) {
+				return;
+			}
+			m_static_size += str.size( );
+			auto const text = append_to_arena( str );
+			if( not m_program.empty( ) ) {
+				// Merge with the previous instruction when it is literal text that ends where this text
+				// starts in the arena, e.g. when an unknown tag separates them
+				auto &last = m_program.back( );
+				if( last.op == parse_template_impl::op_code::raw_text and
+				    last.index + last.size == text.first ) {
+					last.size += text.size;
+					return;
 				}
-				return date::locate_zone( static_cast<std::string>( args[0] ).c_str( ) );
-			}( );
-			m_doc_builder.emplace_back( [&, tz]( daw::io::WriteProxy &writer ) {
-				using namespace date;
-				using namespace std::chrono;
-				std::stringstream ss{ };
-				auto const current_time =
-				  date::make_zoned( tz, floor<seconds>( std::chrono::system_clock::now( ) ) );
-				ss << date::format( "%T", current_time );
-				auto ret = writer.write( ss.str( ) );
-				if( ret.status != io::IOOpStatus::Ok ) {
-					m_on_error( parse_template_error_types::io_error, ss.str( ), "Error writing to output" );
+			}
+			m_program.push_back( parse_template_impl::instruction{
+			  parse_template_impl::op_code::raw_text, text.first, text.size } );
+		}
+
+		/// Copy str into the arena.  The arena holds all text that the compiled template needs, so
+		/// the template string does not need to outlive the parse_template
+		parse_template_impl::text_ref append_to_arena( daw::string_view str ) {
+			if( DAW_UNLIKELY( m_arena.size( ) + str.size( ) >=
+			                  std::numeric_limits<std::uint32_t>::max( ) ) ) {
+				m_on_error( parse_template_error_types::precondition_violation,
+				            str,
+				            "Template is too large" );
+			}
+			auto const first = static_cast<std::uint32_t>( m_arena.size( ) );
+			m_arena.append( str.data( ), str.size( ) );
+			return parse_template_impl::text_ref{ first, static_cast<std::uint32_t>( str.size( ) ) };
+		}
+
+		[[nodiscard]] daw::string_view arena_view( parse_template_impl::text_ref ref ) const {
+			return daw::string_view( m_arena.data( ) + ref.first, ref.size );
+		}
+
+		void check_bindings( ) const {
+			auto missing = std::string( );
+			auto first_missing = daw::string_view( );
+			for( auto const &slot : m_slots ) {
+				if( not slot.is_missing( ) ) {
+					continue;
+				}
+				if( missing.empty( ) ) {
+					first_missing = slot.name;
+				} else {
+					missing += ", ";
 				}
+				missing.append( slot.name.data( ), slot.name.size( ) );
+			}
+			if( not missing.empty( ) ) {
+				m_on_error( parse_template_error_types::unknown_function,
+				            first_missing,
+				            "Attempt to call an undefined function: " + missing );
+			}
+			m_is_finalized.store( true, std::memory_order_release );
+		}
+
+		void write_to_impl( daw::io::WriteProxy &writer, void *state ) const {
+			render_program( writer, state, [&]( daw::string_view text ) {
+				parse_template_impl::write_text( m_on_error, writer, text );
 			} );
 		}
 
-		void process_text( daw::string_view str ) {
-			m_doc_builder.emplace_back( parse_template_impl::raw_text_func( m_on_error, str ) );
+		void
+		profile_to_impl( daw::io::WriteProxy &writer, void *state, render_profile &profile ) const {
+			if( profile.size( ) != m_call_sites.size( ) + m_time_parts.size( ) ) {
+				m_on_error( parse_template_error_types::precondition_violation,
+				            { },
+				            "The profile was not made for this template" );
+			}
+			auto control = parse_template_impl::profile_control( profile );
+			stream_to_impl( writer, state, control );
+		}
+
+		static std::string time_tag_name( parse_template_impl::op_code op ) {
+			switch( op ) {
+			case parse_template_impl::op_code::date:
+				return "date";
+			case parse_template_impl::op_code::time:
+				return "time";
+			default:
+				return "timestamp";
+			}
+		}
+
+		template<typename Control>
+		void stream_to_impl( daw::io::WriteProxy &writer, void *state, Control &control ) const {
+			auto const on_literal = [&]( daw::string_view text ) {
+				parse_template_impl::write_text( m_on_error, writer, text );
+			};
+			render_program( writer, state, on_literal, control );
+		}
+
+		template<typename OnLiteral, typename Control = parse_template_impl::no_render_control>
+		void render_program( daw::io::WriteProxy &writer,
+		                     void *state,
+		                     OnLiteral &&on_literal,
+		                     Control &&control = Control{ } ) const {
+			if( DAW_UNLIKELY( not is_finalized( ) ) ) {
+				check_bindings( );
+			}
+			render_range( 0, m_program.size( ), writer, state, on_literal, control );
 		}
 
-		void write_to_impl( daw::io::WriteProxy &writable, void *state ) {
-			for( auto const &part : m_doc_builder ) {
-				part( writable, state );
+		/// Render the instructions from first up to last
+		template<typename OnLiteral, typename Control>
+		void render_range( std::size_t first,
+		                   std::size_t last,
+		                   daw::io::WriteProxy &writer,
+		                   void *state,
+		                   OnLiteral &on_literal,
+		                   Control &control ) const {
+			for( std::size_t n = first; n < last; ) {
+				if constexpr( not std::is_same_v<std::decay_t<Control>,
+				                                 parse_template_impl::no_render_control> ) {
+					if( control.stopped( ) ) {
+						return;
+					}
+				}
+				n = render_instruction( n, writer, state, on_literal, control );
+			}
+		}
+
+		std::size_t
+		render_part_impl( std::size_t n, daw::io::WriteProxy &writer, void *state ) const {
+			if( DAW_UNLIKELY( not is_finalized( ) ) ) {
+				check_bindings( );
+			}
+			auto const on_literal = [&]( daw::string_view text ) {
+				parse_template_impl::write_text( m_on_error, writer, text );
+			};
+			return render_instruction( n,
+			                           writer,
+			                           state,
+			                           on_literal,
+			                           parse_template_impl::no_render_control{ } );
+		}
+
+		/// Render the instruction at n and return the position of the next one
+		template<typename OnLiteral, typename Control>
+		DAW_ATTRIB_INLINE std::size_t render_instruction( std::size_t n,
+		                                                  daw::io::WriteProxy &writer,
+		                                                  void *state,
+		                                                  OnLiteral &on_literal,
+		                                                  Control &&control ) const {
+			auto const &inst = m_program[n];
+			switch( inst.op ) {
+			case parse_template_impl::op_code::raw_text:
+				on_literal( daw::string_view( m_arena.data( ) + inst.index, inst.size ) );
+				break;
+			case parse_template_impl::op_code::call:
+				if constexpr( parse_template_impl::is_profile_control_v<Control> ) {
+					render_profiled( inst, writer, state, control );
+				} else {
+					auto const &site = m_call_sites[inst.index];
+					site.invoke( writer, state, site.escape.value_or( m_default_escape ) );
+				}
+				break;
+			case parse_template_impl::op_code::date:
+			case parse_template_impl::op_code::time:
+			case parse_template_impl::op_code::timestamp: {
+				if constexpr( parse_template_impl::is_profile_control_v<Control> ) {
+					render_profiled( inst, writer, state, control );
+				} else {
+					parse_template_impl::write_timestamp( m_on_error,
+					                                      writer,
+					                                      *m_time_parts[inst.index].cache );
+				}
+				break;
+			}
+			case parse_template_impl::op_code::flush:
+				control.flush( );
+				break;
+			case parse_template_impl::op_code::cache_begin:
+				return render_cache_block( n, writer, state, control );
+			case parse_template_impl::op_code::if_begin:
+				return render_if_block( n, writer, state, on_literal, control );
+			case parse_template_impl::op_code::each_begin:
+				return render_each_block( n, writer, state, on_literal, control );
+			case parse_template_impl::op_code::cache_end:
+			case parse_template_impl::op_code::if_else:
+			case parse_template_impl::op_code::if_end:
+			case parse_template_impl::op_code::each_end:
+				break;
+			}
+			return n + 1;
+		}
+
+		/// Render a call, date, time, or timestamp instruction and record it in the profile.  The
+		/// output goes to the control's scratch string first so that its size can be counted
+		DAW_ATTRIB_NOINLINE void
+		render_profiled( parse_template_impl::instruction inst,
+		                 daw::io::WriteProxy &writer,
+		                 void *state,
+		                 parse_template_impl::profile_control &control ) const {
+			using clock_t = std::chrono::steady_clock;
+			auto &scratch = control.scratch;
+			scratch.clear( );
+			auto scratch_writer = daw::io::WriteProxy( scratch );
+			auto const is_call = inst.op == parse_template_impl::op_code::call;
+			auto const tag_index = is_call ? inst.index : m_call_sites.size( ) + inst.index;
+			auto const start = clock_t::now( );
+			try {
+				if( is_call ) {
+					auto const &site = m_call_sites[inst.index];
+					site.invoke( scratch_writer, state, site.escape.value_or( m_default_escape ) );
+				} else {
+					parse_template_impl::write_timestamp( m_on_error,
+					                                      scratch_writer,
+					                                      *m_time_parts[inst.index].cache );
+				}
+			} catch( ... ) {
+				control.profile.record( tag_index, clock_t::now( ) - start, scratch.size( ), true );
+				throw;
+			}
+			control.profile.record( tag_index, clock_t::now( ) - start, scratch.size( ), false );
+			parse_template_impl::write_text( m_on_error, writer, scratch );
+		}
+
+		// Blocks are kept out of line so that the common instructions stay small enough to inline
+		template<typename OnLiteral, typename Control>
+		DAW_ATTRIB_NOINLINE std::size_t render_if_block( std::size_t n,
+		                                                 daw::io::WriteProxy &writer,
+		                                                 void *state,
+		                                                 OnLiteral &on_literal,
+		                                                 Control &control ) const {
+			auto const &site = m_block_sites[m_program[n].index];
+			if( site.test( state ) ) {
+				render_range( n + 1, site.else_pos, writer, state, on_literal, control );
+			} else {
+				render_range( site.else_pos + 1, site.end, writer, state, on_literal, control );
+			}
+			return site.end + 1;
+		}
+
+		template<typename OnLiteral, typename Control>
+		DAW_ATTRIB_NOINLINE std::size_t render_each_block( std::size_t n,
+		                                                   daw::io::WriteProxy &writer,
+		                                                   void *state,
+		                                                   OnLiteral &on_literal,
+		                                                   Control &control ) const {
+			auto const &site = m_block_sites[m_program[n].index];
+			auto const render_body = [&]( void *item_state ) {
+				render_range( n + 1, site.end, writer, item_state, on_literal, control );
+			};
+			site.loop( state, parse_template_impl::block_body( render_body ) );
+			return site.end + 1;
+		}
+
+		/// Write the cached output of the cache block starting at n, or render the block and cache
+		/// it.  The block is rendered to a string first as the writer may not be readable, with the
+		/// render's control, so its tags are profiled and a flush inside it passes on the output
+		/// before the block.  A block whose render is stopped is not cached.  Returns the position
+		/// after the block
+		template<typename Control>
+		DAW_ATTRIB_NOINLINE std::size_t render_cache_block( std::size_t n,
+		                                                    daw::io::WriteProxy &writer,
+		                                                    void *state,
+		                                                    Control &control ) const {
+			auto const &block = m_cache_blocks[m_program[n].index];
+			auto const key = arena_view( block.key );
+			if( auto cached = m_fragment_cache->find( key ); cached ) {
+				parse_template_impl::write_text( m_on_error, writer, *cached );
+				return block.end + 1;
+			}
+			auto text = std::string( );
+			auto block_writer = daw::io::WriteProxy( text );
+			auto const on_literal = [&]( daw::string_view literal ) {
+				parse_template_impl::write_text( m_on_error, block_writer, literal );
+			};
+			render_range( n + 1, block.end, block_writer, state, on_literal, control );
+			if constexpr( not std::is_same_v<Control, parse_template_impl::no_render_control> ) {
+				if( control.stopped( ) ) {
+					return block.end + 1;
+				}
 			}
+			parse_template_impl::write_text( m_on_error, writer, text );
+			m_fragment_cache->insert( key, std::move( text ), block.ttl );
+			return block.end + 1;
 		}
 	}; // class parse_template
 
@@ -0,0 +1,489 @@
+// The MIT License (MIT)
+//
+// Copyright (c) Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "daw_parse_template.h"
+
+#if defined( __cpp_impl_coroutine ) and __has_include( <coroutine> )
+
+#include <daw/daw_move.h>
+#include <daw/daw_string_view.h>
+#include <daw/io/daw_write_proxy.h>
+
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#define DAW_PARSE_TEMPLATE_HAS_ASYNC
+
+namespace daw {
+	/// A lazily started coroutine producing a T.  Awaiting it starts it and resumes the awaiter
+	/// when it completes.  A task that is not awaited is started with start( ) and its result
+	/// read with get( ) once done( )
+	template<typename T>
+	class async_task {
+	public:
+		struct promise_type {
+			std::optional<T> value{ };
+			std::exception_ptr error{ };
+			std::coroutine_handle<> continuation{ };
+
+			async_task get_return_object( ) noexcept {
+				return async_task( std::coroutine_handle<promise_type>::from_promise( *this ) );
+			}
+
+			std::suspend_always initial_suspend( ) noexcept {
+				return { };
+			}
+
+			auto final_suspend( ) noexcept {
+				struct final_awaiter {
+					bool await_ready( ) noexcept {
+						return false;
+					}
+
+					std::coroutine_handle<>
+					await_suspend( std::coroutine_handle<promise_type> h ) noexcept {
+						if( auto c = h.promise( ).continuation; c ) {
+							return c;
+						}
+						return std::noop_coroutine( );
+					}
+
+					void await_resume( ) noexcept {}
+				};
+				return final_awaiter{ };
+			}
+
+			template<typename U>
+			void return_value( U &&v ) {
+				value.emplace( DAW_FWD( v ) );
+			}
+
+			void unhandled_exception( ) noexcept {
+				error = std::current_exception( );
+			}
+		};
+
+	private:
+		std::coroutine_handle<promise_type> m_handle{ };
+		bool m_started = false;
+
+		explicit async_task( std::coroutine_handle<promise_type> h ) noexcept
+		  : m_handle( h ) {}
+
+		T take_result( ) {
+			auto &p = m_handle.promise( );
+			if( p.error ) {
+				std::rethrow_exception( p.error );
+			}
+			return std::move( *p.value );
+		}
+
+	public:
+		async_task( ) = default;
+
+		async_task( async_task &&other ) noexcept
+		  : m_handle( std::exchange( other.m_handle, { } ) )
+		  , m_started( other.m_started ) {}
+
+		async_task &operator=( async_task &&rhs ) noexcept {
+			if( this != &rhs ) {
+				if( m_handle ) {
+					m_handle.destroy( );
+				}
+				m_handle = std::exchange( rhs.m_handle, { } );
+				m_started = rhs.m_started;
+			}
+			return *this;
+		}
+
+		~async_task( ) {
+			if( m_handle ) {
+				m_handle.destroy( );
+			}
+		}
+
+		/// Run the task until it first suspends or completes.  Does nothing if it has already started
+		void start( ) {
+			if( m_handle and not m_started ) {
+				m_started = true;
+				m_handle.resume( );
+			}
+		}
+
+		[[nodiscard]] bool done( ) const noexcept {
+			return not m_handle or m_handle.done( );
+		}
+
+		/// The result of a completed task.  Exceptions thrown by the task are rethrown here
+		T get( ) {
+			if( not m_handle or not m_handle.done( ) ) {
+				throw std::logic_error( "async_task::get called before the task completed" );
+			}
+			return take_result( );
+		}
+
+		auto operator co_await( ) && noexcept {
+			struct awaiter {
+				async_task &task;
+
+				bool await_ready( ) const noexcept {
+					return task.done( );
+				}
+
+				std::coroutine_handle<> await_suspend( std::coroutine_handle<> awaiting ) noexcept {
+					task.m_handle.promise( ).continuation = awaiting;
+					if( std::exchange( task.m_started, true ) ) {
+						// Already running, it resumes awaiting when it completes
+						return std::noop_coroutine( );
+					}
+					return task.m_handle;
+				}
+
+				T await_resume( ) {
+					return task.take_result( );
+				}
+			};
+			return awaiter{ *this };
+		}
+	};
+
+	/// A single threaded run queue.  Coroutines that co_await schedule( ), and completions that
+	/// are posted, are resumed in order by run_one/run on the thread calling them
+	class local_executor {
+		std::deque<std::coroutine_handle<>> m_ready{ };
+
+	public:
+		void post( std::coroutine_handle<> h ) {
+			m_ready.push_back( h );
+		}
+
+		/// Suspend the awaiting coroutine and queue it to be resumed by this executor
+		auto schedule( ) noexcept {
+			struct awaiter {
+				local_executor &executor;
+
+				bool await_ready( ) const noexcept {
+					return false;
+				}
+
+				void await_suspend( std::coroutine_handle<> h ) {
+					executor.post( h );
+				}
+
+				void await_resume( ) const noexcept {}
+			};
+			return awaiter{ *this };
+		}
+
+		/// Resume the next queued coroutine.  Returns false when nothing was queued
+		bool run_one( ) {
+			if( m_ready.empty( ) ) {
+				return false;
+			}
+			auto h = m_ready.front( );
+			m_ready.pop_front( );
+			h.resume( );
+			return true;
+		}
+
+		/// Resume queued coroutines until the queue is empty, returning how many were resumed
+		std::size_t run( ) {
+			std::size_t count = 0;
+			while( run_one( ) ) {
+				++count;
+			}
+			return count;
+		}
+
+		[[nodiscard]] bool empty( ) const noexcept {
+			return m_ready.empty( );
+		}
+	};
+
+	/// Start task and run executor until it completes.  Throws std::logic_error if the executor
+	/// runs out of work while the task is still suspended
+	template<typename T>
+	T sync_wait( local_executor &executor, async_task<T> task ) {
+		task.start( );
+		while( not task.done( ) ) {
+			if( not executor.run_one( ) ) {
+				throw std::logic_error( "sync_wait: the task is suspended and the executor has no work" );
+			}
+		}
+		return task.get( );
+	}
+
+	namespace parse_template_impl {
+		/// The state passed through parse_template while rendering an async_template.  An async call
+		/// site leaves the started callback in pending and the render awaits it before the next part,
+		/// escaping its value as escape, the escaping of the call site
+		struct async_frame {
+			void *state = nullptr;
+			std::optional<async_task<std::string>> pending{ };
+			escape_mode escape = escape_mode::none;
+		};
+
+		template<typename State, typename ErrorHandler>
+		State &frame_state( ErrorWrapper<ErrorHandler> const &on_error, void *frame ) {
+			auto *state = static_cast<async_frame *>( frame )->state;
+			if( not state ) {
+				on_error( parse_template_error_types::unknown_tag,
+				          daw::string_view{ },
+				          "Stateful function expects state param on render call" );
+			}
+			return *static_cast<State *>( state );
+		}
+
+		template<typename Result>
+		std::string to_text( Result &&value ) {
+			if constexpr( daw::traits::is_string_view_like_v<std::remove_cvref_t<Result>> ) {
+				return std::string( std::data( value ), std::size( value ) );
+			} else {
+				using parse_template_impl::to_string;
+				using std::to_string;
+				return std::string( to_string( DAW_FWD( value ) ) );
+			}
+		}
+
+		/// Call an async callback, await its value, and convert it to the text to output.  The task
+		/// starts lazily, so the arguments are copied into its frame where they live until it
+		/// completes, and callbacks may take them by reference.  callback must outlive the task
+		template<typename Callback, typename... Args>
+		async_task<std::string> await_call( Callback const &callback, Args... args ) {
+			co_return to_text( co_await callback( args... ) );
+		}
+
+		/// As await_call, passing state after the arguments
+		template<typename Callback, typename State, typename... Args>
+		async_task<std::string>
+		await_stateful_call( Callback const &callback, State &state, Args... args ) {
+			co_return to_text( co_await callback( args..., state ) );
+		}
+	} // namespace parse_template_impl
+
+	/// A template whose callbacks may be asynchronous.  An async callback returns an awaitable,
+	/// such as an async_task, instead of a value.  Rendering suspends at that call, keeping the
+	/// output so far, and continues with the awaited value once it completes, so the output is
+	/// in template order.  One thread can have many renders in flight, each suspended on its own
+	/// callback.  Synchronous callbacks can be mixed with async ones.  <%cache%> blocks are
+	/// rendered synchronously, so an async callback called inside one is an error when it is
+	/// added.  <%if%> and <%each%> blocks are not supported and are an error when the template is
+	/// compiled
+	template<typename ErrorHandler = parse_template_impl::default_error_handler_t>
+	class async_template {
+		using frame_t = parse_template_impl::async_frame;
+
+		DAW_NO_UNIQUE_ADDRESS parse_template_impl::ErrorWrapper<ErrorHandler> m_on_error{ };
+		parse_template<ErrorHandler> m_template;
+
+	public:
+		explicit async_template( daw::string_view template_string )
+		  : m_template( template_string ) {
+			check_block_tags( );
+		}
+
+		async_template( daw::string_view template_string, ErrorHandler on_error )
+		  : m_on_error( on_error )
+		  , m_template( template_string, std::move( on_error ) ) {
+			check_block_tags( );
+		}
+
+		/// Bind a synchronous callback, as parse_template::add_callback.  Callbacks taking a void *
+		/// are passed the state given to render
+		template<typename... ArgTypes, typename Callback>
+		void add_callback( daw::string_view name, Callback &&callback ) {
+			using callback_t = std::decay_t<Callback> const;
+			if constexpr( std::is_invocable_v<callback_t &,
+			                                  parse_template_impl::actual_type_t<ArgTypes>...,
+			                                  daw::io::WriteProxy &,
+			                                  void *> ) {
+				m_template.template add_callback<ArgTypes...>(
+				  name,
+				  [callback = DAW_FWD( callback )]( parse_template_impl::actual_type_t<ArgTypes>... args,
+				                                    daw::io::WriteProxy &writer,
+				                                    void *frame ) {
+					  return callback( std::move( args )..., writer, static_cast<frame_t *>( frame )->state );
+				  } );
+			} else if constexpr( std::is_invocable_v<callback_t &,
+			                                         parse_template_impl::actual_type_t<ArgTypes>...,
+			                                         void *> ) {
+				m_template.template add_callback<ArgTypes...>(
+				  name,
+				  [callback = DAW_FWD( callback )]( parse_template_impl::actual_type_t<ArgTypes>... args,
+				                                    void *frame ) {
+					  return callback( std::move( args )..., static_cast<frame_t *>( frame )->state );
+				  } );
+			} else {
+				m_template.template add_callback<ArgTypes...>( name, DAW_FWD( callback ) );
+			}
+		}
+
+		/// Bind a synchronous callback that is passed the state given to render
+		template<typename StateType, typename... ArgTypes, typename Callback>
+		void add_stateful_callback( daw::string_view name, Callback &&callback ) {
+			using state_t = std::remove_reference_t<StateType>;
+			m_template.template add_callback<ArgTypes...>(
+			  name,
+			  [on_error = m_on_error, callback = DAW_FWD( callback )](
+			    parse_template_impl::actual_type_t<ArgTypes>... args,
+			    daw::io::WriteProxy &writer,
+			    void *frame ) {
+				  auto &state = parse_template_impl::frame_state<state_t>( on_error, frame );
+				  auto bound = [&]( auto &&...as ) {
+					  return callback( DAW_FWD( as )..., state );
+				  };
+				  parse_template_impl::write_to_output_nostate(
+				    on_error, bound, writer, escape_mode::none, std::move( args )... );
+			  } );
+		}
+
+		/// Bind a callback returning an awaitable.  The value it produces is output like the result
+		/// of a synchronous callback.  The callback is called when the render reaches the tag, and
+		/// its arguments live until the awaitable completes
+		template<typename... ArgTypes, typename Callback>
+		void add_async_callback( daw::string_view name, Callback &&callback ) {
+			check_async_call_sites( name );
+			m_template.template add_callback<ArgTypes...>(
+			  name,
+			  [callback = DAW_FWD( callback )]( parse_template_impl::actual_type_t<ArgTypes>... args,
+			                                    daw::io::WriteProxy &,
+			                                    void *frame ) {
+				  static_cast<frame_t *>( frame )->pending =
+				    parse_template_impl::await_call( callback, std::move( args )... );
+			  } );
+		}
+
+		/// Bind a callback returning an awaitable that is passed the state given to render
+		template<typename StateType, typename... ArgTypes, typename Callback>
+		void add_async_stateful_callback( daw::string_view name, Callback &&callback ) {
+			check_async_call_sites( name );
+			using state_t = std::remove_reference_t<StateType>;
+			m_template.template add_callback<ArgTypes...>(
+			  name,
+			  [on_error = m_on_error, callback = DAW_FWD( callback )](
+			    parse_template_impl::actual_type_t<ArgTypes>... args,
+			    daw::io::WriteProxy &,
+			    void *frame ) {
+				  auto &state = parse_template_impl::frame_state<state_t>( on_error, frame );
+				  static_cast<frame_t *>( frame )->pending =
+				    parse_template_impl::await_stateful_call( callback, state, std::move( args )... );
+			  } );
+		}
+
+		void finalize( ) {
+			m_template.finalize( );
+		}
+
+		/// Escape the output of call tags that have no escape attribute, as
+		/// parse_template::set_default_escape
+		void set_default_escape( escape_mode escape ) noexcept {
+			m_template.set_default_escape( escape );
+		}
+
+		[[nodiscard]] escape_mode default_escape( ) const noexcept {
+			return m_template.default_escape( );
+		}
+
+		[[nodiscard]] std::size_t size_estimate( ) const noexcept {
+			return m_template.size_estimate( );
+		}
+
+		/// Render the template.  The async_template must outlive the returned task
+		async_task<std::string> render( ) const {
+			return render_impl( nullptr );
+		}
+
+		/// Render the template with state.  The async_template and state must outlive the returned
+		/// task
+		template<typename T>
+		async_task<std::string> render( T &state ) const {
+			static_assert( not std::is_const_v<T>, "Only mutable state is supported" );
+			return render_impl( reinterpret_cast<void *>( std::addressof( state ) ) );
+		}
+
+	private:
+		/// An <%each%> block passes each item as the state to its body, where the callbacks of an
+		/// async_template expect their frame, and neither block could suspend on an async call
+		void check_block_tags( ) const {
+			if( m_template.has_block_tags( ) ) {
+				m_on_error( parse_template_error_types::unknown_tag,
+				            { },
+				            "<%if%> and <%each%> blocks are not supported by async_template" );
+			}
+		}
+
+		/// Blocks are rendered as one part, so a render could not suspend on an async call inside
+		/// one and its output would be out of order and missing from the cached block
+		void check_async_call_sites( daw::string_view name ) const {
+			if( m_template.is_called_in_block( name ) ) {
+				m_on_error( parse_template_error_types::unknown_tag,
+				            name,
+				            "Async callbacks cannot be called inside a block" );
+			}
+		}
+
+		async_task<std::string> render_impl( void *state ) const {
+			auto result = std::string( );
+			result.reserve( m_template.size_hint( ) );
+			auto writer = daw::io::WriteProxy( result );
+			auto frame = frame_t{ state };
+			auto const count = m_template.part_count( );
+			for( std::size_t n = 0; n < count; ) {
+				frame.escape = m_template.part_escape( n );
+				n = m_template.render_part( n, writer, frame );
+				if( not frame.pending ) {
+					continue;
+				}
+				auto pending = std::move( *frame.pending );
+				frame.pending.reset( );
+				auto text = std::string( );
+				try {
+					text = co_await std::move( pending );
+				} catch( std::exception const &ex ) {
+					m_on_error( parse_template_error_types::callback_exception, { }, ex.what( ) );
+				} catch( ... ) {
+					m_on_error( parse_template_error_types::callback_exception,
+					            { },
+					            "Exception while calling callback" );
+				}
+				auto const wret = parse_template_impl::write_output( writer, text, frame.escape );
+				if( DAW_UNLIKELY( wret.status != daw::io::IOOpStatus::Ok ) ) {
+					m_on_error( parse_template_error_types::io_error, text, "Error writing to output" );
+				}
+			}
+			co_return result;
+		}
+	};
+} // namespace daw
+
+#endif
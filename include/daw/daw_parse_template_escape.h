@@ -0,0 +1,70 @@
+// The MIT License (MIT)
+//
+// Copyright (c) Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <daw/daw_string_view.h>
+#include <daw/io/daw_write_proxy.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace daw {
+	/// How the output of a call tag is escaped, set with escape="..." on the tag or
+	/// parse_template::set_default_escape
+	enum class escape_mode : std::uint8_t {
+		/// Output is written as is
+		none,
+		/// & < > " and ' are replaced with character references
+		html,
+		/// As html, and also ` = and control characters and whitespace, so that the output is safe
+		/// in unquoted attribute values
+		attr,
+		/// Everything but letters, digits, and - . _ ~ is percent encoded
+		url,
+		/// " \ and control characters are escaped for use inside a JSON string
+		json,
+	};
+
+	namespace parse_template_impl {
+		/// The mode named by name, html, attr, url, json, or none
+		[[nodiscard]] std::optional<escape_mode> parse_escape_mode( daw::string_view name ) noexcept;
+
+		/// Position of the first character of str that mode escapes, or npos.  Uses the instruction
+		/// set selected for the delimiter scanners
+		[[nodiscard]] std::size_t find_escape( daw::string_view str, escape_mode mode ) noexcept;
+
+		/// Write str to writer escaped for mode.  Runs of characters that need no escaping are
+		/// written as is
+		daw::io::IOOpResult
+		write_escaped( daw::io::WriteProxy &writer, daw::string_view str, escape_mode mode );
+
+		/// A buffer for output that has to be escaped after it is written, such as that of
+		/// callbacks writing to the WriteProxy.  Buffers are reused by the thread, give it back
+		/// with release_escape_buffer when done
+		[[nodiscard]] std::string take_escape_buffer( );
+		void release_escape_buffer( std::string &&buffer ) noexcept;
+	} // namespace parse_template_impl
+} // namespace daw
@@ -0,0 +1,94 @@
+// The MIT License (MIT)
+//
+// Copyright (c) Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <daw/daw_string_view.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace daw {
+	/// Selects the parse_template constructor that loads an image written by
+	/// parse_template::write_image instead of compiling template text
+	struct template_image_t {
+		explicit template_image_t( ) = default;
+	};
+	inline constexpr template_image_t template_image{ };
+
+	namespace parse_template_impl {
+		/// The layout of a template image.  An image is a header, then a fixed size record for each
+		/// instruction of the program, then the text the records refer to.  Text is referred to by
+		/// its offset from the start of the text, so an image can be loaded from anywhere in memory.
+		/// Numbers are in the byte order of the machine that wrote the image, images written on a
+		/// machine with another byte order are rejected
+		inline constexpr std::uint32_t image_version = 1;
+		inline constexpr std::size_t image_header_size = 28;
+		inline constexpr std::size_t image_record_size = 28;
+
+		struct image_text {
+			std::uint32_t first = 0;
+			std::uint32_t size = 0;
+		};
+
+		struct image_header {
+			std::uint32_t record_count = 0;
+			std::uint32_t text_size = 0;
+			std::uint8_t default_escape = 0;
+		};
+
+		/// An instruction of the program along with what is needed to add it again.  The meaning of
+		/// first, second, and value depends on op:
+		///   raw_text: first is the text
+		///   call: first is the name, second the arguments, and value the tag offset. escape is 0
+		///     when the tag has no escape attribute, otherwise the escape_mode plus 1
+		///   date, time, timestamp: first is the time zone name, empty for the system's time zone,
+		///     second is the format, and value the tag offset
+		///   cache_begin: first is the key and value the ttl in seconds
+		///   if_begin, each_begin: first is the name and second the arguments
+		struct image_record {
+			std::uint8_t op = 0;
+			std::uint8_t escape = 0;
+			image_text first{ };
+			image_text second{ };
+			std::uint64_t value = 0;
+		};
+
+		void append_image_header( std::string &out, image_header const &header );
+		void append_image_record( std::string &out, image_record const &record );
+
+		/// Read the header of image and check that the image is complete.  Returns an empty view
+		/// when image is valid, otherwise a description of the problem
+		[[nodiscard]] daw::string_view read_image_header( daw::string_view image,
+		                                                  image_header &header ) noexcept;
+
+		/// Record n of an image whose header has been read
+		[[nodiscard]] image_record read_image_record( daw::string_view image,
+		                                              std::size_t n ) noexcept;
+
+		/// The text of an image whose header has been read
+		[[nodiscard]] daw::string_view read_image_text( daw::string_view image,
+		                                                image_header const &header ) noexcept;
+	} // namespace parse_template_impl
+} // namespace daw
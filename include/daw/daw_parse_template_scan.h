@@ -0,0 +1,77 @@
+// The MIT License (MIT)
+//
+// Copyright (c) Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <daw/daw_string_view.h>
+
+#include <cstddef>
+
+namespace daw::parse_template_impl {
+	/// The instruction sets the delimiter scanners can use.  The best one supported by the CPU is
+	/// selected the first time a scanner is called
+	enum class simd_level { scalar, sse2, avx2 };
+
+	/// The instruction set the scanners are currently using
+	[[nodiscard]] simd_level active_simd_level( ) noexcept;
+
+	/// The best instruction set supported by this CPU and build
+	[[nodiscard]] simd_level supported_simd_level( ) noexcept;
+
+	/// Use level for all future scans, limited to what is supported.  Intended for tests and
+	/// benchmarks comparing the implementations.  Returns the level that is now active
+	simd_level set_simd_level( simd_level level ) noexcept;
+
+	/// Position of the first occurrence of the two character sequence c0 c1 in str, or npos
+	[[nodiscard]] std::size_t find_pair( daw::string_view str, char c0, char c1 ) noexcept;
+
+	/// Position of the first character in str that is one of c0, c1, or c2, or npos.  Pass the
+	/// same character more than once to search for fewer
+	[[nodiscard]] std::size_t
+	find_first_of( daw::string_view str, char c0, char c1, char c2 ) noexcept;
+
+	/// As find_first_of, starting at pos.  The result is relative to the start of str
+	[[nodiscard]] inline std::size_t
+	find_first_of( daw::string_view str, std::size_t pos, char c0, char c1, char c2 ) noexcept {
+		if( pos >= str.size( ) ) {
+			return daw::string_view::npos;
+		}
+		auto const result =
+		  find_first_of( daw::string_view( str.data( ) + pos, str.size( ) - pos ), c0, c1, c2 );
+		return result == daw::string_view::npos ? result : result + pos;
+	}
+
+	/// Return the text before the first c0 c1 and remove it, and the c0 c1, from the front of str.
+	/// When there is no c0 c1 all of str is returned and str is left empty
+	inline daw::string_view pop_front_until_pair( daw::string_view &str, char c0, char c1 ) {
+		auto const pos = find_pair( str, c0, c1 );
+		if( pos == daw::string_view::npos ) {
+			auto result = str;
+			str.remove_prefix( str.size( ) );
+			return result;
+		}
+		auto result = str.substr( 0, pos );
+		str.remove_prefix( pos + 2 );
+		return result;
+	}
+} // namespace daw::parse_template_impl
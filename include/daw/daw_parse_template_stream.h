@@ -0,0 +1,152 @@
+// The MIT License (MIT)
+//
+// Copyright (c) Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "daw_parse_template.h"
+
+#include <daw/daw_move.h>
+#include <daw/daw_string_view.h>
+#include <daw/io/daw_write_proxy.h>
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <ostream>
+#include <streambuf>
+#include <type_traits>
+#include <vector>
+
+namespace daw {
+	/// Returned by a chunked_stream sink.  stop ends the render, for example when the client has
+	/// gone away
+	enum class stream_status { ok, stop };
+
+	struct chunked_stream_options {
+		/// The most output held before it is passed to the sink
+		std::size_t buffer_size = 16U * 1024U;
+		/// When not zero, output that has been held for this long is passed to the sink at the next
+		/// write or tag, even when the buffer is not full
+		std::chrono::microseconds max_latency{ 0 };
+	};
+
+	struct chunked_stream_result {
+		/// The number of bytes passed to the sink
+		std::size_t bytes = 0;
+		/// The number of times the sink was called
+		std::size_t chunks = 0;
+		/// The sink returned stream_status::stop and the render ended early
+		bool stopped = false;
+	};
+
+	/// Renders templates through a fixed size buffer, passing the output to a sink in chunks.  A
+	/// chunk is passed to the sink when the buffer is full, at each <%flush%> tag, when output has
+	/// been held for longer than max_latency, and at the end of the render.  The sink may block to
+	/// apply backpressure or return stream_status::stop to end the render.  Memory use is bounded
+	/// by buffer_size, the buffer is reused for every render
+	class chunked_stream : private std::streambuf {
+		std::function<stream_status( daw::string_view )> m_sink;
+		std::vector<char> m_buffer;
+		std::chrono::steady_clock::duration m_max_latency;
+		std::chrono::steady_clock::time_point m_first_pending{ };
+		chunked_stream_result m_result{ };
+
+		/// Passed to parse_template::stream_to so that <%flush%> tags flush and a stop ends the render
+		struct render_control {
+			chunked_stream &stream;
+
+			void flush( ) {
+				stream.flush( );
+			}
+
+			bool stopped( ) {
+				// Each tag is a chance to pass on output that has been held too long
+				stream.flush_if_stale( );
+				return stream.m_result.stopped;
+			}
+		};
+
+		template<typename Sink>
+		static std::function<stream_status( daw::string_view )> make_sink( Sink &&sink ) {
+			if constexpr( std::is_void_v<std::invoke_result_t<Sink &, daw::string_view>> ) {
+				return [sink = DAW_FWD( sink )]( daw::string_view chunk ) mutable {
+					sink( chunk );
+					return stream_status::ok;
+				};
+			} else {
+				return DAW_FWD( sink );
+			}
+		}
+
+		void reset( );
+		void flush_if_stale( );
+		void note_pending( );
+
+		int_type overflow( int_type ch ) override;
+		std::streamsize xsputn( char const *s, std::streamsize count ) override;
+		int sync( ) override;
+
+		template<typename Render>
+		chunked_stream_result render_impl( Render &&render ) {
+			reset( );
+			auto os = std::ostream( static_cast<std::streambuf *>( this ) );
+			// Let exceptions thrown by the sink reach the caller instead of only setting badbit
+			os.exceptions( std::ios::badbit );
+			auto writer = daw::io::WriteProxy( os );
+			auto control = render_control{ *this };
+			render( writer, control );
+			flush( );
+			return m_result;
+		}
+
+	public:
+		/// sink is called with each chunk, and returns a stream_status or nothing
+		template<typename Sink>
+		explicit chunked_stream( Sink &&sink, chunked_stream_options const &options = { } )
+		  : m_sink( make_sink( DAW_FWD( sink ) ) )
+		  , m_buffer( options.buffer_size == 0 ? 1 : options.buffer_size )
+		  , m_max_latency( options.max_latency ) {
+			reset( );
+		}
+
+		chunked_stream( chunked_stream const & ) = delete;
+		chunked_stream &operator=( chunked_stream const & ) = delete;
+
+		template<typename ErrorHandler>
+		chunked_stream_result render( parse_template<ErrorHandler> const &tmp ) {
+			return render_impl( [&]( daw::io::WriteProxy &writer, render_control &control ) {
+				tmp.stream_to( writer, control );
+			} );
+		}
+
+		template<typename ErrorHandler, typename T>
+		chunked_stream_result render( parse_template<ErrorHandler> const &tmp, T &state ) {
+			return render_impl( [&]( daw::io::WriteProxy &writer, render_control &control ) {
+				tmp.stream_to( writer, control, state );
+			} );
+		}
+
+		/// Pass any buffered output to the sink.  Returns false once the sink has stopped the stream
+		bool flush( );
+	};
+} // namespace daw
@@ -0,0 +1,145 @@
+// The MIT License (MIT)
+//
+// Copyright (c) Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <daw/daw_string_view.h>
+
+#include <date/date.h>
+#include <date/tz.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace daw::parse_template_impl {
+	/// A strftime style format string, as used by date::format, compiled into a list of field
+	/// writers.  Fields are written directly to a caller supplied buffer without iostreams.  When
+	/// the format uses a specifier that is not supported, every format call falls back to
+	/// date::format.  The global locale is sampled once, when the format is first compiled, and
+	/// timestamp caches are shared by the whole process, so a format first compiled under a locale
+	/// other than the classic one always falls back and later locale changes are not seen
+	class timestamp_formatter {
+	public:
+		enum class field : std::uint8_t {
+			literal,
+			year,
+			year2,
+			century,
+			iso_year,
+			iso_year2,
+			month,
+			month_name,
+			month_abbrev,
+			day,
+			day_space_padded,
+			day_of_year,
+			weekday,
+			iso_weekday,
+			weekday_name,
+			weekday_abbrev,
+			week_of_year_sunday,
+			week_of_year_monday,
+			iso_week_of_year,
+			hour,
+			hour12,
+			am_pm,
+			minute,
+			second,
+			utc_offset,
+			utc_offset_colon,
+			tz_abbrev,
+		};
+
+		/// A single field.  For literal, first and size are the position of the text in the literal
+		/// buffer
+		struct step {
+			field kind;
+			std::uint32_t first = 0;
+			std::uint32_t size = 0;
+		};
+
+		static constexpr std::size_t npos = static_cast<std::size_t>( -1 );
+
+	private:
+		std::string m_fmt;
+		std::string m_literals{ };
+		std::vector<step> m_steps{ };
+		bool m_uses_fallback = false;
+
+		void add_literal( daw::string_view str );
+		void add_field( field kind );
+
+	public:
+		explicit timestamp_formatter( daw::string_view fmt );
+
+		[[nodiscard]] daw::string_view format_string( ) const noexcept {
+			return m_fmt;
+		}
+
+		/// True when the format cannot be handled without date::format
+		[[nodiscard]] bool uses_fallback( ) const noexcept {
+			return m_uses_fallback;
+		}
+
+		/// Format tp, in the time zone described by info, into the buffer [out, out + capacity).
+		/// Returns the number of characters written or npos when the result needs date::format,
+		/// e.g. the format is not supported, the year is outside [0, 9999], or it does not fit
+		[[nodiscard]] std::size_t format_to( char *out,
+		                                     std::size_t capacity,
+		                                     date::sys_seconds tp,
+		                                     date::sys_info const &info ) const;
+
+		/// Format tp in the time zone tz, using date::format when needed
+		[[nodiscard]] std::string format( date::time_zone const *tz, date::sys_seconds tp ) const;
+	};
+
+	/// A time zone shared by every template that uses it, along with its UTC offset transitions
+	/// from a year before it was resolved to 20 years after.  Obtained from resolve_zone
+	class resolved_zone {
+		date::time_zone const *m_tz;
+		std::string m_name;
+		std::vector<date::sys_info> m_transitions{ };
+
+	public:
+		resolved_zone( date::time_zone const *tz, std::string name );
+
+		[[nodiscard]] date::time_zone const *tz( ) const noexcept {
+			return m_tz;
+		}
+
+		/// The name the zone was resolved with, empty for the system's time zone
+		[[nodiscard]] daw::string_view name( ) const noexcept {
+			return m_name;
+		}
+
+		/// The offset and abbreviation in effect at tp.  Times within the transitions are found
+		/// with a binary search, others are looked up in the time zone and stored in fallback
+		[[nodiscard]] date::sys_info const &info( date::sys_seconds tp,
+		                                          date::sys_info &fallback ) const;
+	};
+
+	/// The process wide zone called name, or the system's time zone when name is empty.  Each zone
+	/// is located, and its transitions computed, the first time it is resolved.  Unknown names
+	/// throw as date::locate_zone does
+	[[nodiscard]] resolved_zone const &resolve_zone( daw::string_view name );
+} // namespace daw::parse_template_impl
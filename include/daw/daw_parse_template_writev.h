@@ -0,0 +1,158 @@
+// The MIT License (MIT)
+//
+// Copyright (c) Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "daw_parse_template.h"
+
+#include <daw/daw_string_view.h>
+#include <daw/io/daw_write_proxy.h>
+
+#include <cstddef>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#if __has_include( <sys/uio.h> )
+#define DAW_PARSE_TEMPLATE_HAS_WRITEV
+#endif
+
+namespace daw {
+	/// The output of a render held as a list of segments.  Literal text refers directly to the
+	/// template that was rendered, only the output of calls, dates, times, and timestamps is copied
+	/// into a scratch buffer.  Reuse one across renders to reuse its memory
+	class scatter_gather_output {
+		struct segment {
+			/// Points into the template for literal text, nullptr for dynamic output
+			char const *literal;
+			/// Offset into the scratch buffer for dynamic output
+			std::size_t first;
+			std::size_t size;
+		};
+
+		std::string m_scratch{ };
+		std::vector<segment> m_segments{ };
+		std::size_t m_dynamic_end = 0;
+		std::size_t m_size = 0;
+
+		void end_dynamic( ) {
+			if( m_scratch.size( ) > m_dynamic_end ) {
+				auto const sz = m_scratch.size( ) - m_dynamic_end;
+				m_segments.push_back( segment{ nullptr, m_dynamic_end, sz } );
+				m_size += sz;
+				m_dynamic_end = m_scratch.size( );
+			}
+		}
+
+		void add_literal( daw::string_view text ) {
+			end_dynamic( );
+			m_segments.push_back( segment{ text.data( ), 0, text.size( ) } );
+			m_size += text.size( );
+		}
+
+	public:
+		scatter_gather_output( ) = default;
+
+		/// Remove all segments, keeping the memory for the next render
+		void clear( ) noexcept {
+			m_scratch.clear( );
+			m_segments.clear( );
+			m_dynamic_end = 0;
+			m_size = 0;
+		}
+
+		/// Render tmp into this output, replacing the previous contents.  The output refers to tmp and
+		/// must not outlive it
+		template<typename ErrorHandler>
+		void render( parse_template<ErrorHandler> const &tmp ) {
+			clear( );
+			auto writer = daw::io::WriteProxy( m_scratch );
+			tmp.write_split_to( writer, [&]( daw::string_view text ) { add_literal( text ); } );
+			end_dynamic( );
+		}
+
+		template<typename ErrorHandler, typename T>
+		void render( parse_template<ErrorHandler> const &tmp, T &state ) {
+			clear( );
+			auto writer = daw::io::WriteProxy( m_scratch );
+			tmp.write_split_to(
+			  writer,
+			  [&]( daw::string_view text ) { add_literal( text ); },
+			  state );
+			end_dynamic( );
+		}
+
+		/// The total number of bytes in the output
+		[[nodiscard]] std::size_t size( ) const noexcept {
+			return m_size;
+		}
+
+		[[nodiscard]] std::size_t segment_count( ) const noexcept {
+			return m_segments.size( );
+		}
+
+		/// Call func with a daw::string_view of each segment, in order
+		template<typename Func>
+		void for_each_segment( Func &&func ) const {
+			for( auto const &seg : m_segments ) {
+				if( seg.literal != nullptr ) {
+					func( daw::string_view( seg.literal, seg.size ) );
+				} else {
+					func( daw::string_view( m_scratch.data( ) + seg.first, seg.size ) );
+				}
+			}
+		}
+
+		/// Append all segments to a single string
+		[[nodiscard]] std::string to_string( ) const {
+			auto result = std::string( );
+			result.reserve( m_size );
+			for_each_segment( [&]( daw::string_view sv ) { result.append( sv.data( ), sv.size( ) ); } );
+			return result;
+		}
+	};
+
+#if defined( DAW_PARSE_TEMPLATE_HAS_WRITEV )
+	/// Write all of output to the file descriptor fd with writev, in batches of at most IOV_MAX
+	/// segments.  Partial writes are resumed and writes interrupted by a signal are retried.
+	/// Returns the number of bytes written, which is less than output.size( ) when ec is set
+	std::size_t write_to_fd( int fd, scatter_gather_output const &output, std::error_code &ec );
+
+	/// Render tmp directly to the file descriptor fd.  Literal text is written from the template
+	/// without being copied
+	template<typename ErrorHandler>
+	std::size_t write_to_fd( int fd, parse_template<ErrorHandler> const &tmp, std::error_code &ec ) {
+		auto output = scatter_gather_output( );
+		output.render( tmp );
+		return write_to_fd( fd, output, ec );
+	}
+
+	template<typename ErrorHandler, typename T>
+	std::size_t
+	write_to_fd( int fd, parse_template<ErrorHandler> const &tmp, T &state, std::error_code &ec ) {
+		auto output = scatter_gather_output( );
+		output.render( tmp, state );
+		return write_to_fd( fd, output, ec );
+	}
+#endif
+} // namespace daw
@@ -0,0 +1,103 @@
+// The MIT License (MIT)
+//
+// Copyright (c) Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <daw/daw_string_view.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace daw {
+	/// Per tag counters of the renders made with parse_template::profile_to.  There is one set of
+	/// counters for each call, date, time, and timestamp tag of the template the profile was made
+	/// for.  The counters are atomic so that concurrent renders may share a profile
+	class render_profile {
+	public:
+		/// The number of latency histogram buckets
+		static constexpr std::size_t bucket_count = 16;
+
+		/// The exclusive upper bound, in nanoseconds, of histogram bucket n.  Each bucket is twice as
+		/// wide as the one before and the last has no upper bound
+		static constexpr std::uint64_t bucket_limit( std::size_t n ) noexcept {
+			return std::uint64_t{ 256 } << n;
+		}
+
+		/// Identifies a tag by the callback name, or date, time, or timestamp, and the offset of the
+		/// tag in the template source.  Included tags have the offset in their own template
+		struct tag {
+			std::string name;
+			std::size_t offset;
+		};
+
+		/// The counters of a tag at the time snapshot was called
+		struct tag_counters {
+			render_profile::tag tag;
+			std::uint64_t calls = 0;
+			/// Calls that ended with an exception
+			std::uint64_t errors = 0;
+			std::uint64_t bytes = 0;
+			std::uint64_t total_ns = 0;
+			std::array<std::uint64_t, bucket_count> histogram{ };
+		};
+
+		explicit render_profile( std::vector<tag> tags );
+
+		[[nodiscard]] std::size_t size( ) const noexcept {
+			return m_tags.size( );
+		}
+
+		void record( std::size_t tag_index,
+		             std::chrono::nanoseconds elapsed,
+		             std::size_t bytes,
+		             bool failed ) noexcept;
+
+		[[nodiscard]] std::vector<tag_counters> snapshot( ) const;
+
+		/// The snapshot as one line per tag
+		[[nodiscard]] std::string to_text( ) const;
+
+		/// The snapshot as a JSON object with a tags array and the bucket limits of the histograms
+		[[nodiscard]] std::string to_json( ) const;
+
+		void reset( ) noexcept;
+
+	private:
+		struct counters {
+			std::atomic<std::uint64_t> calls{ 0 };
+			std::atomic<std::uint64_t> errors{ 0 };
+			std::atomic<std::uint64_t> bytes{ 0 };
+			std::atomic<std::uint64_t> total_ns{ 0 };
+			std::array<std::atomic<std::uint64_t>, bucket_count> histogram{ };
+		};
+
+		std::vector<tag> m_tags;
+		std::unique_ptr<counters[]> m_counters;
+	};
+} // namespace daw
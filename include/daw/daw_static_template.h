@@ -0,0 +1,783 @@
+// The MIT License (MIT)
+//
+// Copyright (c) Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "daw_parse_template.h"
+
+#if defined( __cpp_nontype_template_args ) and __cpp_nontype_template_args >= 201911L
+
+#include <daw/daw_move.h>
+#include <daw/daw_string_view.h>
+#include <daw/io/daw_write_proxy.h>
+
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#define DAW_PARSE_TEMPLATE_HAS_STATIC_TEMPLATE
+
+namespace daw {
+	/// A string literal that can be passed as a template parameter
+	template<std::size_t N>
+	struct fixed_string {
+		char data[N]{ };
+
+		constexpr fixed_string( char const ( &str )[N] ) noexcept {
+			for( std::size_t n = 0; n < N; ++n ) {
+				data[n] = str[n];
+			}
+		}
+
+		[[nodiscard]] static constexpr std::size_t size( ) noexcept {
+			return N - 1;
+		}
+
+		[[nodiscard]] constexpr std::string_view view( ) const noexcept {
+			return std::string_view( data, N - 1 );
+		}
+	};
+
+	namespace static_template_impl {
+		/// Reaching this while parsing a template at compile time is a compile error, and the reason
+		/// is shown in the compiler's diagnostic
+		inline void static_template_error( char const *reason ) {
+			throw std::logic_error( reason );
+		}
+
+		enum class part_kind { text, call, date, time, timestamp, flush };
+
+		/// A step of a compiled static template.  For text, a is the text.  For a call, a is the
+		/// callback name and b its arguments.  For date and time, a is the time zone.  For a
+		/// timestamp, a is the format and b the time zone.  Positions are offsets into the template
+		struct part {
+			part_kind kind = part_kind::text;
+			std::size_t a_first = 0;
+			std::size_t a_size = 0;
+			std::size_t b_first = 0;
+			std::size_t b_size = 0;
+		};
+
+		struct range {
+			std::size_t first = 0;
+			std::size_t size = 0;
+		};
+
+		/// The position of needle in str at or after pos, or npos.  This avoids std::string_view::find
+		/// as some compilers cannot use it on template parameter objects during constant evaluation
+		constexpr std::size_t
+		find( std::string_view str, std::string_view needle, std::size_t pos = 0 ) {
+			for( ; pos + needle.size( ) <= str.size( ); ++pos ) {
+				std::size_t n = 0;
+				while( n < needle.size( ) and str[pos + n] == needle[n] ) {
+					++n;
+				}
+				if( n == needle.size( ) ) {
+					return pos;
+				}
+			}
+			return std::string_view::npos;
+		}
+
+		constexpr bool is_space( char c ) noexcept {
+			return c == ' ' or c == '\t' or c == '\n' or c == '\r' or c == '\f' or c == '\v';
+		}
+
+		/// The arguments of a tag, the text after args=" up to the first double-quote that is not
+		/// preceded by a backslash.  Empty when there is no args="
+		constexpr range find_args( std::string_view src, std::size_t first, std::size_t last ) {
+			auto const tag = src.substr( first, last - first );
+			auto const start = find( tag, R"(args=")" );
+			if( start == std::string_view::npos ) {
+				return range{ last, 0 };
+			}
+			auto const args_first = start + 6;
+			for( std::size_t n = args_first; n < tag.size( ); ++n ) {
+				if( tag[n] == '"' and tag[n - 1] != '\\' ) {
+					return range{ first + args_first, n - args_first };
+				}
+			}
+			static_template_error( "Could not find end of call args" );
+			return { };
+		}
+
+		/// Split args on the commas that are not within quotes, as find_split_args does
+		template<std::size_t MaxCount>
+		constexpr std::array<range, MaxCount>
+		split_args( std::string_view src, range args, std::size_t &count ) {
+			auto result = std::array<range, MaxCount>{ };
+			count = 0;
+			auto const add = [&]( std::size_t first, std::size_t last ) {
+				if( count == MaxCount ) {
+					static_template_error( "Unexpected argument count" );
+				}
+				result[count++] = range{ first, last - first };
+			};
+			bool in_quote = false;
+			std::size_t last_pos = args.first;
+			auto const end = args.first + args.size;
+			for( std::size_t n = args.first; n < end; ++n ) {
+				if( src[n] == '"' ) {
+					if( n == args.first or src[n - 1] != '\\' ) {
+						static_template_error( "Unexpected unescaped double-quote" );
+					}
+					in_quote = not in_quote;
+				} else if( src[n] == ',' and not in_quote ) {
+					add( last_pos, n );
+					last_pos = n + 1;
+				}
+			}
+			if( last_pos < end ) {
+				add( last_pos, end );
+			}
+			return result;
+		}
+
+		constexpr bool starts_with( std::string_view str, std::string_view prefix ) {
+			return find( str.substr( 0, prefix.size( ) ), prefix ) == 0;
+		}
+
+		constexpr part parse_time_tag( part_kind kind,
+		                               std::string_view src,
+		                               std::size_t first,
+		                               std::size_t last,
+		                               std::size_t max_args ) {
+			std::size_t count = 0;
+			auto const args = split_args<2>( src, find_args( src, first, last ), count );
+			if( count > max_args ) {
+				static_template_error( "Unexpected argument count" );
+			}
+			auto result = part{ kind };
+			if( count > 0 ) {
+				result.a_first = args[0].first;
+				result.a_size = args[0].size;
+			}
+			if( count > 1 ) {
+				result.b_first = args[1].first;
+				result.b_size = args[1].size;
+			}
+			return result;
+		}
+
+		constexpr part parse_tag( std::string_view src, std::size_t first, std::size_t last ) {
+			while( first < last and is_space( src[first] ) ) {
+				++first;
+			}
+			auto const tag = src.substr( first, last - first );
+			if( tag.empty( ) ) {
+				static_template_error( "Empty tag" );
+			}
+			if( starts_with( tag, "call" ) ) {
+				auto const args = find_args( src, first + 4, last );
+				if( args.size == 0 ) {
+					static_template_error( "Could not find start of call args" );
+				}
+				// Static templates do not escape, so an escape attribute would be silently dropped
+				auto const args_end = args.first + args.size;
+				if( find( src.substr( first + 4, args.first - first - 4 ), "escape=" ) !=
+				      std::string_view::npos or
+				    find( src.substr( args_end, last - args_end ), "escape=" ) != std::string_view::npos ) {
+					static_template_error( "escape is not supported by static_template" );
+				}
+				auto const arg_text = src.substr( args.first, args.size );
+				auto const comma = find( arg_text, "," );
+				auto const name_size = comma == std::string_view::npos ? args.size : comma;
+				if( name_size == 0 ) {
+					static_template_error( "Invalid call name, cannot be empty" );
+				}
+				auto result = part{ part_kind::call, args.first, name_size };
+				if( comma != std::string_view::npos ) {
+					result.b_first = args.first + comma + 1;
+					result.b_size = args.size - comma - 1;
+				}
+				return result;
+			}
+			if( starts_with( tag, "date" ) ) {
+				return parse_time_tag( part_kind::date, src, first + 4, last, 1 );
+			}
+			if( starts_with( tag, "timestamp" ) ) {
+				return parse_time_tag( part_kind::timestamp, src, first + 9, last, 2 );
+			}
+			if( starts_with( tag, "time" ) ) {
+				return parse_time_tag( part_kind::time, src, first + 4, last, 1 );
+			}
+			if( starts_with( tag, "flush" ) ) {
+				// There is no streaming render of a static_template, a flush outputs nothing
+				return part{ part_kind::flush };
+			}
+			static_template_error( "Unknown tag" );
+			return { };
+		}
+
+		/// Call on_part with each part of src, in order
+		template<typename OnPart>
+		constexpr void parse_template_text( std::string_view src, OnPart on_part ) {
+			std::size_t pos = 0;
+			while( pos < src.size( ) ) {
+				auto const open = find( src, "<%", pos );
+				auto const text_end = open == std::string_view::npos ? src.size( ) : open;
+				if( text_end > pos ) {
+					on_part( part{ part_kind::text, pos, text_end - pos } );
+				}
+				if( open == std::string_view::npos ) {
+					return;
+				}
+				auto const close = find( src, "%>", open + 2 );
+				if( close == std::string_view::npos ) {
+					static_template_error( "Unexpected empty tag, could not find %>" );
+				}
+				on_part( parse_tag( src, open + 2, close ) );
+				pos = close + 2;
+			}
+		}
+
+		template<fixed_string Text>
+		constexpr std::size_t part_count( ) {
+			std::size_t result = 0;
+			parse_template_text( Text.view( ), [&]( part const & ) { ++result; } );
+			return result;
+		}
+
+		template<fixed_string Text>
+		constexpr auto parse_parts( ) {
+			auto result = std::array<part, part_count<Text>( )>{ };
+			std::size_t n = 0;
+			parse_template_text( Text.view( ), [&]( part const &p ) { result[n++] = p; } );
+			return result;
+		}
+
+		/// Split the arguments of a call the way parse_args_from_string does, on every comma, and
+		/// require one per parameter of the callback
+		template<std::size_t Count>
+		constexpr std::array<range, Count> split_call_args( std::string_view src, part const &p ) {
+			auto result = std::array<range, Count>{ };
+			std::size_t count = 0;
+			auto pos = p.b_first;
+			auto const end = p.b_first + p.b_size;
+			while( pos < end ) {
+				auto const comma = find( src.substr( pos, end - pos ), "," );
+				auto const last = comma == std::string_view::npos ? end : pos + comma;
+				if( count == Count ) {
+					static_template_error( "Unexpected argument count" );
+				}
+				result[count++] = range{ pos, last - pos };
+				pos = last == end ? end : last + 1;
+			}
+			if( count != Count ) {
+				static_template_error( "Unexpected argument count" );
+			}
+			return result;
+		}
+
+		/// The characters of an escaped_string argument after unescaping it and removing surrounding
+		/// quotes
+		template<std::size_t N>
+		struct static_string {
+			char data[N + 1]{ };
+
+			[[nodiscard]] constexpr std::string_view view( ) const noexcept {
+				return std::string_view( data, N );
+			}
+		};
+
+		constexpr char unescape( char c ) noexcept {
+			switch( c ) {
+			case 'a':
+				return '\a';
+			case 'b':
+				return '\b';
+			case 'f':
+				return '\f';
+			case 'n':
+				return '\n';
+			case 'r':
+				return '\r';
+			case 't':
+				return '\t';
+			case 'v':
+				return '\v';
+			default:
+				return c;
+			}
+		}
+
+		/// Call on_char with each character of str after unescaping it
+		template<typename OnChar>
+		constexpr void for_each_unescaped( std::string_view str, OnChar on_char ) {
+			for( std::size_t n = 0; n < str.size( ); ++n ) {
+				auto c = str[n];
+				if( c == '\\' ) {
+					if( ++n == str.size( ) ) {
+						static_template_error( "Invalid escape sequence" );
+					}
+					c = unescape( str[n] );
+				}
+				on_char( c );
+			}
+		}
+
+		/// The range of the unescaped characters of str that remain after removing surrounding
+		/// quotes, as trim_quotes does
+		constexpr range unescaped_range( std::string_view str ) {
+			std::size_t size = 0;
+			char first = 0;
+			char last = 0;
+			for_each_unescaped( str, [&]( char c ) {
+				if( size == 0 ) {
+					first = c;
+				}
+				last = c;
+				++size;
+			} );
+			if( size >= 2 and first == '"' and last == '"' ) {
+				return range{ 1, size - 2 };
+			}
+			return range{ 0, size };
+		}
+
+		template<std::size_t N>
+		constexpr static_string<N> unescape_string( std::string_view str ) {
+			auto const keep = unescaped_range( str );
+			auto result = static_string<N>{ };
+			std::size_t pos = 0;
+			for_each_unescaped( str, [&]( char c ) {
+				if( pos >= keep.first and pos < keep.first + keep.size ) {
+					result.data[pos - keep.first] = c;
+				}
+				++pos;
+			} );
+			return result;
+		}
+
+		template<typename T>
+		constexpr T parse_integer( std::string_view str ) {
+			while( not str.empty( ) and is_space( str.front( ) ) ) {
+				str.remove_prefix( 1 );
+			}
+			while( not str.empty( ) and is_space( str.back( ) ) ) {
+				str.remove_suffix( 1 );
+			}
+			bool is_negative = false;
+			if( not str.empty( ) and ( str.front( ) == '-' or str.front( ) == '+' ) ) {
+				is_negative = str.front( ) == '-';
+				if( is_negative and std::is_unsigned_v<T> ) {
+					static_template_error( "Negative value for an unsigned argument" );
+				}
+				str.remove_prefix( 1 );
+			}
+			if( str.empty( ) ) {
+				static_template_error( "Expected a number" );
+			}
+			// Accumulate the magnitude, which for the most negative value is one more than the max
+			auto const limit = static_cast<unsigned long long>( std::numeric_limits<T>::max( ) ) +
+			                   ( is_negative ? 1ULL : 0ULL );
+			unsigned long long result = 0;
+			for( char c : str ) {
+				if( c < '0' or c > '9' ) {
+					static_template_error( "Expected a number" );
+				}
+				auto const digit = static_cast<unsigned long long>( c - '0' );
+				if( result > ( limit - digit ) / 10 ) {
+					static_template_error( "Number is out of range for the argument type" );
+				}
+				result = result * 10 + digit;
+			}
+			if( is_negative and result > 0 ) {
+				return static_cast<T>( -static_cast<long long>( result - 1 ) - 1 );
+			}
+			return static_cast<T>( result );
+		}
+
+		/// The type an argument is stored as in the compiled template
+		template<typename T>
+		struct view_type {
+			using type = T;
+		};
+
+		template<>
+		struct view_type<escaped_string> {
+			using type = std::string_view;
+		};
+
+		template<>
+		struct view_type<std::string> {
+			using type = std::string_view;
+		};
+
+		template<typename T>
+		using view_type_t = typename view_type<T>::type;
+
+		/// The value of an argument, parsed at compile time
+		template<fixed_string Text, typename T, std::size_t First, std::size_t Size>
+		struct static_arg {
+			static constexpr auto parse( ) {
+				constexpr auto str = Text.view( ).substr( First, Size );
+				if constexpr( std::is_same_v<T, bool> ) {
+					if( str == "true" ) {
+						return true;
+					}
+					if( str != "false" ) {
+						static_template_error( "Expected true or false" );
+					}
+					return false;
+				} else if constexpr( std::is_integral_v<T> ) {
+					return parse_integer<T>( str );
+				} else if constexpr( std::is_same_v<T, std::string_view> or
+				                     std::is_same_v<T, std::string> ) {
+					return str;
+				} else if constexpr( std::is_same_v<T, daw::string_view> ) {
+					return daw::string_view( str.data( ), str.size( ) );
+				} else {
+					static_assert( std::is_same_v<T, escaped_string>,
+					               "Static templates support integral, bool, string, string_view, and "
+					               "escaped_string arguments" );
+					return unescape_string<unescaped_range( str ).size>( str );
+				}
+			}
+
+			static constexpr auto storage = parse( );
+
+			static constexpr view_type_t<T> value( ) noexcept {
+				if constexpr( std::is_same_v<T, escaped_string> ) {
+					return storage.view( );
+				} else {
+					return storage;
+				}
+			}
+		};
+
+		template<typename Callback, typename... Args>
+		constexpr bool is_callable_with_v =
+		  std::is_invocable_v<Callback const &, Args..., daw::io::WriteProxy &, void *> or
+		  std::is_invocable_v<Callback const &, Args..., daw::io::WriteProxy &> or
+		  std::is_invocable_v<Callback const &, Args..., void *> or
+		  std::is_invocable_v<Callback const &, Args...>;
+
+		template<typename Callback, typename State, typename... Args>
+		constexpr bool is_stateful_callable_with_v =
+		  std::is_invocable_v<Callback const &, Args..., daw::io::WriteProxy &, State &> or
+		  std::is_invocable_v<Callback const &, Args..., State &>;
+	} // namespace static_template_impl
+
+	/// A callback for a static_template.  State is void for callbacks that do not take the render
+	/// state
+	template<fixed_string Name, typename State, typename Callback, typename... ArgTypes>
+	struct static_callback_t {
+		static constexpr auto name = Name;
+		static constexpr std::size_t arg_count = sizeof...( ArgTypes );
+		using state_t = State;
+		using arg_types = std::tuple<ArgTypes...>;
+
+		Callback callback;
+	};
+
+	/// A callback called Name with arguments of ArgTypes, as with parse_template::add_callback
+	template<fixed_string Name, typename... ArgTypes, typename Callback>
+	constexpr auto static_callback( Callback &&callback ) {
+		return static_callback_t<Name, void, std::decay_t<Callback>, ArgTypes...>{
+		  DAW_FWD( callback ) };
+	}
+
+	/// A callback called Name that is passed the render state, as with
+	/// parse_template::add_stateful_callback
+	template<fixed_string Name, typename StateType, typename... ArgTypes, typename Callback>
+	constexpr auto static_stateful_callback( Callback &&callback ) {
+		static_assert( not std::is_const_v<std::remove_reference_t<StateType>>,
+		               "Only mutable state is supported" );
+		return static_callback_t<Name,
+		                         std::remove_reference_t<StateType>,
+		                         std::decay_t<Callback>,
+		                         ArgTypes...>{ DAW_FWD( callback ) };
+	}
+
+	template<typename... Callbacks>
+	struct static_callbacks {
+		std::tuple<Callbacks...> callbacks;
+	};
+
+	template<typename... Callbacks>
+	constexpr static_callbacks<Callbacks...> make_static_callbacks( Callbacks... callbacks ) {
+		return { std::tuple<Callbacks...>( std::move( callbacks )... ) };
+	}
+
+	/// A template parsed entirely at compile time.  Literal text is written straight from Text, and
+	/// each call is dispatched to its callback, with arguments parsed at compile time.  Malformed
+	/// tags, unknown tags, calls to callbacks that are not passed to the render, and incorrect
+	/// argument counts are compile errors
+	template<fixed_string Text, typename ErrorHandler = parse_template_impl::default_error_handler_t>
+	class static_template {
+		using part_kind = static_template_impl::part_kind;
+		static constexpr auto parts = static_template_impl::parse_parts<Text>( );
+		static constexpr auto default_timestamp_format = std::string_view( "%Y-%m-%dT%T%z" );
+
+		DAW_NO_UNIQUE_ADDRESS parse_template_impl::ErrorWrapper<ErrorHandler> m_on_error{ };
+
+		static constexpr std::size_t compute_static_size( ) noexcept {
+			std::size_t result = 0;
+			for( auto const &p : parts ) {
+				if( p.kind == part_kind::text ) {
+					result += p.a_size;
+				}
+			}
+			return result;
+		}
+
+		static constexpr std::size_t compute_dynamic_size_estimate( ) noexcept {
+			std::size_t result = 0;
+			for( auto const &p : parts ) {
+				switch( p.kind ) {
+				case part_kind::text:
+				case part_kind::flush:
+					break;
+				case part_kind::call:
+					result += parse_template_impl::call_size_estimate;
+					break;
+				case part_kind::date:
+					result += parse_template_impl::date_size_estimate;
+					break;
+				case part_kind::time:
+					result += parse_template_impl::time_size_estimate;
+					break;
+				case part_kind::timestamp: {
+					auto const fmt = p.a_size == 0 ? default_timestamp_format : view( p.a_first, p.a_size );
+					result += parse_template_impl::timestamp_size_estimate(
+					  daw::string_view( fmt.data( ), fmt.size( ) ) );
+					break;
+				}
+				}
+			}
+			return result;
+		}
+
+		static constexpr std::string_view view( std::size_t first, std::size_t size ) noexcept {
+			return Text.view( ).substr( first, size );
+		}
+
+		template<typename Tuple, std::size_t Idx = 0>
+		static constexpr std::size_t find_callback( std::string_view name ) noexcept {
+			if constexpr( Idx == std::tuple_size_v<Tuple> ) {
+				return Idx;
+			} else {
+				if( std::tuple_element_t<Idx, Tuple>::name.view( ) == name ) {
+					return Idx;
+				}
+				return find_callback<Tuple, Idx + 1>( name );
+			}
+		}
+
+		static parse_template_impl::resolved_zone const &get_zone( std::string_view name ) {
+			return parse_template_impl::resolve_zone( daw::string_view( name.data( ), name.size( ) ) );
+		}
+
+		/// The cache for the date, time, or timestamp part I.  The time zone is looked up on the first
+		/// render, so there is nothing to do at startup
+		template<std::size_t I>
+		static parse_template_impl::timestamp_cache &time_cache( ) {
+			static auto &cache = []( ) -> parse_template_impl::timestamp_cache & {
+				constexpr auto p = parts[I];
+				if constexpr( p.kind == part_kind::date ) {
+					return parse_template_impl::get_timestamp_cache( get_zone( view( p.a_first, p.a_size ) ),
+					                                                 "%Y-%m-%d" );
+				} else if constexpr( p.kind == part_kind::time ) {
+					return parse_template_impl::get_timestamp_cache( get_zone( view( p.a_first, p.a_size ) ),
+					                                                 "%T" );
+				} else {
+					constexpr auto fmt =
+					  p.a_size == 0 ? default_timestamp_format : view( p.a_first, p.a_size );
+					return parse_template_impl::get_timestamp_cache(
+					  get_zone( view( p.b_first, p.b_size ) ),
+					  daw::string_view( fmt.data( ), fmt.size( ) ) );
+				}
+			}( );
+			return cache;
+		}
+
+		template<typename Callback, typename... Args>
+		void
+		invoke( Callback const &cb, daw::io::WriteProxy &writer, void *state, Args... args ) const {
+			using state_t = typename Callback::state_t;
+			if constexpr( std::is_void_v<state_t> ) {
+				auto f = parse_template_impl::make_callback<Args...>(
+				  m_on_error, cb.callback, writer, state, escape_mode::none );
+				f( std::move( args )... );
+			} else {
+				if( not state ) {
+					m_on_error( parse_template_error_types::unknown_tag,
+					            daw::string_view{ },
+					            "Stateful function expects state param on write_to/to_string call" );
+				}
+				auto &s = *static_cast<state_t *>( state );
+				if constexpr( std::is_invocable_v<decltype( cb.callback ) const &,
+				                                  Args...,
+				                                  daw::io::WriteProxy &,
+				                                  state_t &> ) {
+					(void)cb.callback( std::move( args )..., writer, s );
+				} else {
+					auto bound = [&]( ) {
+						return cb.callback( std::move( args )..., s );
+					};
+					parse_template_impl::write_to_output_nostate( m_on_error,
+					                                             bound,
+					                                             writer,
+					                                             escape_mode::none );
+				}
+			}
+		}
+
+		template<std::size_t I, typename Callback, std::size_t... Js>
+		void render_call( Callback const &cb,
+		                  daw::io::WriteProxy &writer,
+		                  void *state,
+		                  std::index_sequence<Js...> ) const {
+			using arg_types = typename Callback::arg_types;
+			using callback_t = decltype( cb.callback );
+			using state_t = typename Callback::state_t;
+			static constexpr auto args =
+			  static_template_impl::split_call_args<sizeof...( Js )>( Text.view( ), parts[I] );
+			constexpr bool use_views = [] {
+				if constexpr( std::is_void_v<state_t> ) {
+					return static_template_impl::is_callable_with_v<
+					  callback_t,
+					  static_template_impl::view_type_t<std::tuple_element_t<Js, arg_types>>...>;
+				} else {
+					return static_template_impl::is_stateful_callable_with_v<
+					  callback_t,
+					  state_t,
+					  static_template_impl::view_type_t<std::tuple_element_t<Js, arg_types>>...>;
+				}
+			}( );
+			if constexpr( use_views ) {
+				invoke( cb,
+				        writer,
+				        state,
+				        static_template_impl::static_arg<Text,
+				                                         std::tuple_element_t<Js, arg_types>,
+				                                         args[Js].first,
+				                                         args[Js].size>::value( )... );
+			} else {
+				// The callback needs owning strings, as with parse_template
+				invoke( cb,
+				        writer,
+				        state,
+				        parse_template_impl::actual_type_t<std::tuple_element_t<Js, arg_types>>(
+				          static_template_impl::static_arg<Text,
+				                                           std::tuple_element_t<Js, arg_types>,
+				                                           args[Js].first,
+				                                           args[Js].size>::value( ) )... );
+			}
+		}
+
+		template<std::size_t I, typename... Callbacks>
+		DAW_ATTRIB_INLINE void render_part( daw::io::WriteProxy &writer,
+		                                    static_callbacks<Callbacks...> const &cbs,
+		                                    void *state ) const {
+			constexpr auto p = parts[I];
+			if constexpr( p.kind == part_kind::text ) {
+				parse_template_impl::write_text(
+				  m_on_error,
+				  writer,
+				  daw::string_view( Text.data + p.a_first, p.a_size ) );
+			} else if constexpr( p.kind == part_kind::call ) {
+				using tuple_t = std::tuple<Callbacks...>;
+				constexpr auto idx = find_callback<tuple_t>( view( p.a_first, p.a_size ) );
+				static_assert( idx < sizeof...( Callbacks ),
+				               "Attempt to call an undefined function.  The template calls a callback "
+				               "that was not passed to write_to/to_string" );
+				if constexpr( idx < sizeof...( Callbacks ) ) {
+					using callback_t = std::tuple_element_t<idx, tuple_t>;
+					render_call<I>( std::get<idx>( cbs.callbacks ),
+					                writer,
+					                state,
+					                std::make_index_sequence<callback_t::arg_count>{ } );
+				}
+			} else if constexpr( p.kind != part_kind::flush ) {
+				parse_template_impl::write_timestamp( m_on_error, writer, time_cache<I>( ) );
+			}
+		}
+
+		template<typename... Callbacks, std::size_t... Is>
+		void render( daw::io::WriteProxy &writer,
+		             static_callbacks<Callbacks...> const &cbs,
+		             void *state,
+		             std::index_sequence<Is...> ) const {
+			( render_part<Is>( writer, cbs, state ), ... );
+		}
+
+	public:
+		constexpr static_template( ) = default;
+
+		explicit constexpr static_template( ErrorHandler on_error )
+		  : m_on_error( std::move( on_error ) ) {}
+
+		/// The number of bytes of literal text the template outputs
+		[[nodiscard]] static constexpr std::size_t static_size( ) noexcept {
+			return compute_static_size( );
+		}
+
+		/// The estimated number of bytes a render outputs
+		[[nodiscard]] static constexpr std::size_t size_estimate( ) noexcept {
+			return compute_static_size( ) + compute_dynamic_size_estimate( );
+		}
+
+		template<typename... Callbacks>
+		void write_to( daw::io::WriteProxy &writer, static_callbacks<Callbacks...> const &cbs ) const {
+			render( writer, cbs, nullptr, std::make_index_sequence<parts.size( )>{ } );
+		}
+
+		template<typename... Callbacks, typename T>
+		void write_to( daw::io::WriteProxy &writer,
+		               static_callbacks<Callbacks...> const &cbs,
+		               T &state ) const {
+			static_assert( not std::is_const_v<T>, "Only mutable state is supported" );
+			void *state_ptr = reinterpret_cast<void *>( std::addressof( state ) );
+			render( writer, cbs, state_ptr, std::make_index_sequence<parts.size( )>{ } );
+		}
+
+		template<typename... Callbacks>
+		[[nodiscard]] std::string to_string( static_callbacks<Callbacks...> const &cbs ) const {
+			auto result = std::string( );
+			result.reserve( size_estimate( ) );
+			auto writer = daw::io::WriteProxy( result );
+			write_to( writer, cbs );
+			return result;
+		}
+
+		template<typename... Callbacks, typename T>
+		[[nodiscard]] std::string to_string( static_callbacks<Callbacks...> const &cbs,
+		                                     T &state ) const {
+			auto result = std::string( );
+			result.reserve( size_estimate( ) );
+			auto writer = daw::io::WriteProxy( result );
+			write_to( writer, cbs, state );
+			return result;
+		}
+	};
+} // namespace daw
+
+#endif
@@ -0,0 +1,67 @@
+// The MIT License (MIT)
+//
+// Copyright (c) Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "daw_parse_template.h"
+
+#include <daw/daw_memory_mapped_file.h>
+#include <daw/daw_string_view.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <utility>
+
+namespace daw {
+	/// Write the image of tmp, see parse_template::write_image, to the file at path
+	template<typename ErrorHandler>
+	void save_template_image( parse_template<ErrorHandler> const &tmp,
+	                          std::filesystem::path const &path ) {
+		auto const image = tmp.to_image( );
+		auto file = std::ofstream( path, std::ios::binary | std::ios::trunc );
+		if( file ) {
+			file.write( image.data( ), static_cast<std::streamsize>( image.size( ) ) );
+		}
+		if( not file ) {
+			throw std::system_error( std::make_error_code( std::errc::io_error ),
+			                         "Error writing file: " + path.string( ) );
+		}
+	}
+
+	/// Load the template in the image file at path.  The file is mapped and the template is loaded
+	/// from the mapping, which is released before returning
+	template<typename ErrorHandler = parse_template_impl::default_error_handler_t>
+	parse_template<ErrorHandler> load_template_image( std::filesystem::path const &path,
+	                                                  ErrorHandler on_error = ErrorHandler{ } ) {
+		auto const file = daw::filesystem::memory_mapped_file_t<char>( path.string( ) );
+		if( not file ) {
+			throw std::system_error( std::make_error_code( std::errc::io_error ),
+			                         "Error opening file: " + path.string( ) );
+		}
+		return parse_template<ErrorHandler>( template_image,
+		                                     daw::string_view( file.data( ), file.size( ) ),
+		                                     std::move( on_error ) );
+	}
+} // namespace daw
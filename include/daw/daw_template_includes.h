@@ -0,0 +1,121 @@
+// The MIT License (MIT)
+//
+// Copyright (c) Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "daw_parse_template.h"
+
+#include <daw/daw_string_view.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace daw {
+	/// A set of named template sources that <%include args="name"%> tags refer to.  Each source is
+	/// compiled once, on first use, and its parts are spliced into every template including it,
+	/// so an include costs nothing when rendering.  Includes may nest, an include cycle is an error
+	template<typename ErrorHandler = parse_template_impl::default_error_handler_t>
+	class template_includes {
+	public:
+		using template_t = parse_template<ErrorHandler>;
+
+	private:
+		DAW_NO_UNIQUE_ADDRESS ErrorHandler m_on_error{ };
+		parse_template_impl::heterogenous_lookup_map_t<std::string, std::string> m_sources{ };
+		parse_template_impl::heterogenous_lookup_map_t<std::string, std::unique_ptr<template_t>>
+		  m_compiled{ };
+		/// The includes being compiled, outermost first
+		std::vector<std::string> m_compiling{ };
+
+		typename template_t::include_resolver resolver( ) {
+			return [this]( daw::string_view name ) -> template_t const * {
+				return find( name );
+			};
+		}
+
+		[[noreturn]] void report_cycle( daw::string_view name ) const {
+			auto path = std::string( );
+			auto pos = m_compiling.begin( );
+			while( daw::string_view( *pos ) != name ) {
+				++pos;
+			}
+			for( ; pos != m_compiling.end( ); ++pos ) {
+				path += *pos + " -> ";
+			}
+			path.append( name.data( ), name.size( ) );
+			auto const on_error = parse_template_impl::ErrorWrapper<ErrorHandler>( m_on_error );
+			on_error( parse_template_error_types::include_cycle, name, "Include cycle: " + path );
+		}
+
+	public:
+		template_includes( ) = default;
+
+		explicit template_includes( ErrorHandler on_error )
+		  : m_on_error( std::move( on_error ) ) {}
+
+		/// Add, or replace, the template source for name.  Compiled templates are discarded as they
+		/// may include the previous source, templates already compiled from this set are unchanged
+		void add( daw::string_view name, daw::string_view template_string ) {
+			m_sources.insert_or_assign( static_cast<std::string>( name ),
+			                            static_cast<std::string>( template_string ) );
+			m_compiled.clear( );
+		}
+
+		[[nodiscard]] bool contains( daw::string_view name ) const {
+			return m_sources.find( name ) != m_sources.end( );
+		}
+
+		/// The compiled template for name, compiling it and its includes on first use.  Null when
+		/// there is no template named name
+		template_t const *find( daw::string_view name ) {
+			if( auto pos = m_compiled.find( name ); pos != m_compiled.end( ) ) {
+				return pos->second.get( );
+			}
+			auto source = m_sources.find( name );
+			if( source == m_sources.end( ) ) {
+				return nullptr;
+			}
+			for( auto const &compiling : m_compiling ) {
+				if( compiling == name ) {
+					report_cycle( name );
+				}
+			}
+			m_compiling.push_back( source->first );
+			try {
+				auto compiled = std::make_unique<template_t>( source->second, resolver( ), m_on_error );
+				m_compiling.pop_back( );
+				return m_compiled.emplace( source->first, std::move( compiled ) ).first->second.get( );
+			} catch( ... ) {
+				m_compiling.pop_back( );
+				throw;
+			}
+		}
+
+		/// Compile template_string with its include tags resolved against this set
+		template_t compile( daw::string_view template_string ) {
+			return template_t( template_string, resolver( ), m_on_error );
+		}
+	};
+} // namespace daw
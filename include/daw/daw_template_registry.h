@@ -0,0 +1,370 @@
+// The MIT License (MIT)
+//
+// Copyright (c) Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "daw_parse_template.h"
+
+#include <daw/daw_memory_mapped_file.h>
+#include <daw/daw_move.h>
+#include <daw/daw_string_view.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace daw {
+	namespace parse_template_impl {
+		/// Forwards calls to a callback shared by many templates, so each template added to does not
+		/// need its own copy
+		template<typename Callback>
+		struct shared_callback {
+			std::shared_ptr<Callback const> callback;
+
+			template<typename... Args>
+			auto operator( )( Args &&...args ) const
+			  -> decltype( std::declval<Callback const &>( )( DAW_FWD( args )... ) ) {
+				return ( *callback )( DAW_FWD( args )... );
+			}
+		};
+
+		template<typename Callback>
+		shared_callback<std::decay_t<Callback>> share_callback( Callback &&callback ) {
+			return { std::make_shared<std::decay_t<Callback> const>( DAW_FWD( callback ) ) };
+		}
+	} // namespace parse_template_impl
+
+	/// A set of callbacks to add to many templates.  Each callback is stored once and shared by
+	/// every template it is added to.  Callbacks a template does not use are skipped
+	template<typename ErrorHandler = parse_template_impl::default_error_handler_t>
+	class callback_set {
+		std::vector<std::function<void( parse_template<ErrorHandler> & )>> m_binders{ };
+
+	public:
+		callback_set( ) = default;
+
+		template<typename... ArgTypes, typename Callback>
+		callback_set &add_callback( daw::string_view name, Callback &&callback ) {
+			m_binders.push_back( [name = static_cast<std::string>( name ),
+			                      cb = parse_template_impl::share_callback( DAW_FWD( callback ) )](
+			                       parse_template<ErrorHandler> &tmp ) {
+				tmp.template add_callback<ArgTypes...>( name, cb );
+			} );
+			return *this;
+		}
+
+		template<typename StateType, typename... ArgTypes, typename Callback>
+		callback_set &add_stateful_callback( daw::string_view name, Callback &&callback ) {
+			m_binders.push_back( [name = static_cast<std::string>( name ),
+			                      cb = parse_template_impl::share_callback( DAW_FWD( callback ) )](
+			                       parse_template<ErrorHandler> &tmp ) {
+				tmp.template add_stateful_callback<StateType, ArgTypes...>( name, cb );
+			} );
+			return *this;
+		}
+
+		template<typename... ArgTypes, typename Callback>
+		callback_set &add_block_callback( daw::string_view name, Callback &&callback ) {
+			m_binders.push_back( [name = static_cast<std::string>( name ),
+			                      cb = parse_template_impl::share_callback( DAW_FWD( callback ) )](
+			                       parse_template<ErrorHandler> &tmp ) {
+				tmp.template add_block_callback<ArgTypes...>( name, cb );
+			} );
+			return *this;
+		}
+
+		template<typename StateType, typename... ArgTypes, typename Callback>
+		callback_set &add_stateful_block_callback( daw::string_view name, Callback &&callback ) {
+			m_binders.push_back( [name = static_cast<std::string>( name ),
+			                      cb = parse_template_impl::share_callback( DAW_FWD( callback ) )](
+			                       parse_template<ErrorHandler> &tmp ) {
+				tmp.template add_stateful_block_callback<StateType, ArgTypes...>( name, cb );
+			} );
+			return *this;
+		}
+
+		/// Add every callback in the set to tmp and finalize it
+		void bind( parse_template<ErrorHandler> &tmp ) const {
+			for( auto const &binder : m_binders ) {
+				binder( tmp );
+			}
+			tmp.finalize( );
+		}
+	};
+
+	/// Compiles every template in a directory once and serves them by name.  The name of a template
+	/// is its path relative to the directory, using / as the separator.  reload, or a watcher
+	/// started with watch, recompiles templates whose files have changed and swaps them in
+	/// atomically.  Renders that are in flight keep the version they started with
+	template<typename ErrorHandler = parse_template_impl::default_error_handler_t>
+	class template_registry {
+	public:
+		using template_t = parse_template<ErrorHandler>;
+
+		/// A template that failed to compile, with the error from its most recent version
+		struct failure {
+			std::string name;
+			std::string message;
+		};
+
+	private:
+		struct entry {
+			std::shared_ptr<template_t const> tmp;
+			std::filesystem::file_time_type mtime;
+			std::uintmax_t size;
+		};
+
+		struct failed_entry {
+			std::string message;
+			std::filesystem::file_time_type mtime;
+			std::uintmax_t size;
+		};
+
+		using map_t = std::map<std::string, entry, std::less<>>;
+
+		std::filesystem::path m_directory;
+		std::vector<std::string> m_extensions;
+		callback_set<ErrorHandler> m_callbacks;
+		ErrorHandler m_on_error;
+		parse_template_impl::atomic_shared_ptr<map_t const> m_templates{ };
+		// Only held while reloading, never while serving templates
+		mutable std::mutex m_reload_mutex{ };
+		std::map<std::string, failed_entry, std::less<>> m_failures{ };
+
+		std::mutex m_watch_mutex{ };
+		std::condition_variable m_watch_cv{ };
+		bool m_stop_watching = false;
+		std::thread m_watcher{ };
+
+		[[nodiscard]] bool is_template_file( std::filesystem::path const &path ) const {
+			if( m_extensions.empty( ) ) {
+				return true;
+			}
+			auto const ext = path.extension( ).string( );
+			for( auto const &e : m_extensions ) {
+				if( ext == e ) {
+					return true;
+				}
+			}
+			return false;
+		}
+
+		std::shared_ptr<template_t const> compile( std::filesystem::path const &path,
+		                                           std::uintmax_t size ) const {
+			auto result = [&] {
+				if( size == 0 ) {
+					return std::make_shared<template_t>( daw::string_view( ), m_on_error );
+				}
+				auto const file = daw::filesystem::memory_mapped_file_t<char>( path.string( ) );
+				if( not file ) {
+					throw std::system_error( std::make_error_code( std::errc::io_error ),
+					                         "Error opening file: " + path.string( ) );
+				}
+				// The template copies what it needs, so the mapping is released once it is compiled
+				return std::make_shared<template_t>( daw::string_view( file.data( ), file.size( ) ),
+				                                     m_on_error );
+			}( );
+			m_callbacks.bind( *result );
+			return result;
+		}
+
+	public:
+		/// Compile every file in directory, and its subdirectories, whose extension is one of
+		/// extensions.  An empty list of extensions includes every file
+		explicit template_registry( std::filesystem::path directory,
+		                            callback_set<ErrorHandler> callbacks,
+		                            std::vector<std::string> extensions = { },
+		                            ErrorHandler on_error = ErrorHandler( ) )
+		  : m_directory( std::move( directory ) )
+		  , m_extensions( std::move( extensions ) )
+		  , m_callbacks( std::move( callbacks ) )
+		  , m_on_error( std::move( on_error ) ) {
+			m_templates.store( std::make_shared<map_t const>( ) );
+			reload( );
+		}
+
+		template_registry( template_registry const & ) = delete;
+		template_registry &operator=( template_registry const & ) = delete;
+
+		~template_registry( ) {
+			stop_watching( );
+		}
+
+		/// The current version of the template called name, or nullptr when there is no such
+		/// template or it has never compiled.  This never waits for a reload
+		[[nodiscard]] std::shared_ptr<template_t const> get( daw::string_view name ) const {
+			auto const templates = m_templates.load( );
+			auto pos = templates->find( std::string_view( name.data( ), name.size( ) ) );
+			if( pos == templates->end( ) ) {
+				return { };
+			}
+			return pos->second.tmp;
+		}
+
+		/// The number of templates being served
+		[[nodiscard]] std::size_t size( ) const {
+			return m_templates.load( )->size( );
+		}
+
+		/// The names of the templates being served
+		[[nodiscard]] std::vector<std::string> names( ) const {
+			auto const templates = m_templates.load( );
+			auto result = std::vector<std::string>( );
+			result.reserve( templates->size( ) );
+			for( auto const &item : *templates ) {
+				result.push_back( item.first );
+			}
+			return result;
+		}
+
+		/// Templates whose current file failed to compile.  The previous version of each, if any, is
+		/// still served
+		[[nodiscard]] std::vector<failure> failures( ) const {
+			auto const lck = std::lock_guard( m_reload_mutex );
+			auto result = std::vector<failure>( );
+			result.reserve( m_failures.size( ) );
+			for( auto const &item : m_failures ) {
+				result.push_back( failure{ item.first, item.second.message } );
+			}
+			return result;
+		}
+
+		/// Rescan the directory.  New and modified files are compiled, and removed files are no longer
+		/// served.  Files whose modification time and size are unchanged are not read.  Returns the
+		/// number of templates added, replaced, or removed
+		std::size_t reload( ) {
+			auto const lck = std::lock_guard( m_reload_mutex );
+			auto const current = m_templates.load( );
+			auto next = std::make_shared<map_t>( );
+			std::size_t changes = 0;
+
+			auto ec = std::error_code( );
+			auto it = std::filesystem::recursive_directory_iterator( m_directory, ec );
+			auto const last = std::filesystem::recursive_directory_iterator( );
+			for( ; not ec and it != last; it.increment( ec ) ) {
+				auto const &path = it->path( );
+				// Errors for a single file, such as it being removed while scanning, skip that file
+				auto file_ec = std::error_code( );
+				if( not it->is_regular_file( file_ec ) or not is_template_file( path ) ) {
+					continue;
+				}
+				auto name = path.lexically_relative( m_directory ).generic_string( );
+				auto const mtime = std::filesystem::last_write_time( path, file_ec );
+				auto const size = std::filesystem::file_size( path, file_ec );
+				if( file_ec ) {
+					continue;
+				}
+				auto const old = current->find( name );
+				if( old != current->end( ) and old->second.mtime == mtime and
+				    old->second.size == size ) {
+					next->emplace( std::move( name ), old->second );
+					continue;
+				}
+				auto const failed = m_failures.find( name );
+				bool const known_failure = failed != m_failures.end( ) and
+				                           failed->second.mtime == mtime and
+				                           failed->second.size == size;
+				if( not known_failure ) {
+					try {
+						auto tmp = compile( path, size );
+						m_failures.erase( name );
+						next->emplace( std::move( name ), entry{ std::move( tmp ), mtime, size } );
+						++changes;
+						continue;
+					} catch( std::exception const &ex ) {
+						m_failures[name] = failed_entry{ ex.what( ), mtime, size };
+					} catch( ... ) {
+						m_failures[name] = failed_entry{ "Unknown error compiling template", mtime, size };
+					}
+				}
+				// Keep serving the last version that compiled
+				if( old != current->end( ) ) {
+					next->emplace( std::move( name ), old->second );
+				}
+			}
+			if( ec ) {
+				// The scan did not finish, so keep serving what is there rather than dropping the rest
+				return 0;
+			}
+			for( auto const &item : *current ) {
+				if( next->find( item.first ) == next->end( ) ) {
+					++changes;
+				}
+			}
+			for( auto pos = m_failures.begin( ); pos != m_failures.end( ); ) {
+				if( not std::filesystem::exists( m_directory / pos->first, ec ) ) {
+					pos = m_failures.erase( pos );
+				} else {
+					++pos;
+				}
+			}
+			m_templates.store( std::move( next ) );
+			return changes;
+		}
+
+		/// Start a thread that calls reload every interval until stop_watching is called or the
+		/// registry is destroyed
+		void watch( std::chrono::milliseconds interval ) {
+			stop_watching( );
+			m_stop_watching = false;
+			m_watcher = std::thread( [this, interval] {
+				auto lck = std::unique_lock( m_watch_mutex );
+				while( not m_watch_cv.wait_for( lck, interval, [&] { return m_stop_watching; } ) ) {
+					lck.unlock( );
+					try {
+						reload( );
+					} catch( ... ) {
+						// Compile errors are recorded in failures, anything else is retried next interval
+					}
+					lck.lock( );
+				}
+			} );
+		}
+
+		void stop_watching( ) {
+			if( not m_watcher.joinable( ) ) {
+				return;
+			}
+			{
+				auto const lck = std::lock_guard( m_watch_mutex );
+				m_stop_watching = true;
+			}
+			m_watch_cv.notify_all( );
+			m_watcher.join( );
+		}
+	};
+} // namespace daw
@@ -0,0 +1,117 @@
+// The MIT License (MIT)
+//
+// Copyright (c) Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "daw/daw_fragment_cache.h"
+
+#include <daw/daw_string_view.h>
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+namespace daw {
+	fragment_cache::fragment_cache( std::size_t max_bytes )
+	  : m_max_bytes( max_bytes )
+	  , m_shard_max_bytes( max_bytes / shard_count ) {}
+
+	void fragment_cache::shard::erase( std::list<entry>::iterator pos ) {
+		bytes -= pos->bytes( );
+		index.erase( index.find( pos->key ) );
+		lru.erase( pos );
+	}
+
+	fragment_cache::shard &fragment_cache::shard_for( daw::string_view key ) {
+		auto const hash =
+		  std::hash<std::string_view>{ }( std::string_view( key.data( ), key.size( ) ) );
+		return m_shards[hash % shard_count];
+	}
+
+	fragment_cache::value_t fragment_cache::find( daw::string_view key ) {
+		auto &s = shard_for( key );
+		auto const lock = std::lock_guard<std::mutex>( s.mutex );
+		auto pos = s.index.find( std::string_view( key.data( ), key.size( ) ) );
+		if( pos == s.index.end( ) ) {
+			m_misses.fetch_add( 1, std::memory_order_relaxed );
+			return nullptr;
+		}
+		auto it = pos->second;
+		if( it->can_expire and it->expires <= clock_t::now( ) ) {
+			s.erase( it );
+			m_misses.fetch_add( 1, std::memory_order_relaxed );
+			return nullptr;
+		}
+		s.lru.splice( s.lru.begin( ), s.lru, it );
+		m_hits.fetch_add( 1, std::memory_order_relaxed );
+		return it->text;
+	}
+
+	void fragment_cache::insert( daw::string_view key, std::string text, std::chrono::seconds ttl ) {
+		auto e = entry{ static_cast<std::string>( key ),
+		                std::make_shared<std::string const>( std::move( text ) ),
+		                clock_t::now( ) + ttl,
+		                ttl.count( ) > 0 };
+		auto const size = e.bytes( );
+		if( size > m_shard_max_bytes ) {
+			return;
+		}
+		auto &s = shard_for( key );
+		auto const lock = std::lock_guard<std::mutex>( s.mutex );
+		if( auto pos = s.index.find( e.key ); pos != s.index.end( ) ) {
+			// Another render stored the same block first
+			s.erase( pos->second );
+		}
+		while( s.bytes + size > m_shard_max_bytes ) {
+			s.erase( std::prev( s.lru.end( ) ) );
+			m_evictions.fetch_add( 1, std::memory_order_relaxed );
+		}
+		s.lru.push_front( std::move( e ) );
+		s.index.emplace( s.lru.front( ).key, s.lru.begin( ) );
+		s.bytes += size;
+	}
+
+	void fragment_cache::clear( ) {
+		for( auto &s : m_shards ) {
+			auto const lock = std::lock_guard<std::mutex>( s.mutex );
+			s.index.clear( );
+			s.lru.clear( );
+			s.bytes = 0;
+		}
+	}
+
+	fragment_cache::statistics fragment_cache::stats( ) const {
+		auto result = statistics{ m_hits.load( std::memory_order_relaxed ),
+		                          m_misses.load( std::memory_order_relaxed ),
+		                          m_evictions.load( std::memory_order_relaxed ) };
+		for( auto const &s : m_shards ) {
+			auto const lock = std::lock_guard<std::mutex>( s.mutex );
+			result.entries += s.lru.size( );
+			result.bytes += s.bytes;
+		}
+		return result;
+	}
+} // namespace daw
@@ -25,6 +25,14 @@
 #include <daw/daw_string_view.h>
 #include <daw/io/daw_write_proxy.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+
 namespace daw::parse_template_impl {
 	std::string &to_string( std::string &str ) noexcept {
 		return str;
@@ -34,17 +42,93 @@ namespace daw::parse_template_impl {
 		return std::move( str );
 	}
 
-	void parse_template_impl::doc_parts::operator( )( daw::io::WriteProxy &writer,
-	                                                  void *state ) const {
-		m_to_string( writer, state );
+	timestamp_cache::timestamp_cache( resolved_zone const &zone, daw::string_view fmt )
+	  : m_zone( &zone )
+	  , m_formatter( fmt ) {}
+
+	bool timestamp_cache::try_load( std::int64_t second, buffer_t &buffer, std::size_t &size ) const {
+		auto const seq = m_sequence.load( std::memory_order_acquire );
+		if( ( seq & 1U ) != 0 ) {
+			return false;
+		}
+		if( m_second.load( std::memory_order_relaxed ) != second ) {
+			return false;
+		}
+		size = m_size.load( std::memory_order_relaxed );
+		auto const words = ( size + sizeof( std::uint64_t ) - 1 ) / sizeof( std::uint64_t );
+		for( std::size_t n = 0; n < words; ++n ) {
+			auto const word = m_words[n].load( std::memory_order_relaxed );
+			std::memcpy( buffer.data( ) + n * sizeof( std::uint64_t ), &word, sizeof( std::uint64_t ) );
+		}
+		std::atomic_thread_fence( std::memory_order_acquire );
+		return m_sequence.load( std::memory_order_relaxed ) == seq;
+	}
+
+	void timestamp_cache::try_store( std::int64_t second, daw::string_view value ) {
+		if( value.size( ) > max_size ) {
+			return;
+		}
+		auto seq = m_sequence.load( std::memory_order_relaxed );
+		if( ( seq & 1U ) != 0 or
+		    not m_sequence.compare_exchange_strong( seq, seq + 1, std::memory_order_acquire ) ) {
+			// Another thread is refreshing the value
+			return;
+		}
+		std::atomic_thread_fence( std::memory_order_release );
+		auto const words = ( value.size( ) + sizeof( std::uint64_t ) - 1 ) / sizeof( std::uint64_t );
+		for( std::size_t n = 0; n < words; ++n ) {
+			auto word = std::uint64_t{ 0 };
+			auto const offset = n * sizeof( std::uint64_t );
+			std::memcpy( &word,
+			             value.data( ) + offset,
+			             std::min( sizeof( std::uint64_t ), value.size( ) - offset ) );
+			m_words[n].store( word, std::memory_order_relaxed );
+		}
+		m_size.store( value.size( ), std::memory_order_relaxed );
+		m_second.store( second, std::memory_order_relaxed );
+		m_sequence.store( seq + 2, std::memory_order_release );
+	}
+
+	daw::string_view timestamp_cache::get( buffer_t &buffer, std::string &overflow ) {
+		using namespace std::chrono;
+		auto const now = floor<seconds>( system_clock::now( ) );
+		auto const second = static_cast<std::int64_t>( now.time_since_epoch( ).count( ) );
+		auto size = std::size_t{ 0 };
+		if( try_load( second, buffer, size ) ) {
+			return daw::string_view( buffer.data( ), size );
+		}
+		auto fallback = date::sys_info{ };
+		auto const &info = m_zone->info( now, fallback );
+		size = m_formatter.format_to( buffer.data( ), buffer.size( ), now, info );
+		if( size != timestamp_formatter::npos ) {
+			auto const result = daw::string_view( buffer.data( ), size );
+			try_store( second, result );
+			return result;
+		}
+		overflow = m_formatter.format( m_zone->tz( ), now );
+		try_store( second, overflow );
+		return overflow;
+	}
+
+	timestamp_cache &get_timestamp_cache( resolved_zone const &zone, daw::string_view fmt ) {
+		static std::mutex cache_mutex{ };
+		static std::map<std::pair<resolved_zone const *, std::string>,
+		                std::unique_ptr<timestamp_cache>>
+		  caches{ };
+
+		auto const lock = std::lock_guard<std::mutex>( cache_mutex );
+		auto &cache = caches[std::make_pair( &zone, static_cast<std::string>( fmt ) )];
+		if( not cache ) {
+			cache = std::make_unique<timestamp_cache>( zone, fmt );
+		}
+		return *cache;
 	}
 
-	std::string trim_quotes( daw::string_view str ) {
+	void trim_quotes( std::string &str ) {
 		if( str.size( ) >= 2 and str.front( ) == '"' and str.back( ) == '"' ) {
-			str.remove_prefix( );
-			str.remove_suffix( );
+			str.pop_back( );
+			str.erase( 0, 1 );
 		}
-		return static_cast<std::string>( str );
 	}
 
 	std::string parse_to_value( daw::string_view str, daw::tag_t<escaped_string> ) {
@@ -81,6 +165,7 @@ namespace daw::parse_template_impl {
 				result += unescape( str.pop_front( ) );
 			}
 		}
-		return parse_template_impl::trim_quotes( result );
+		parse_template_impl::trim_quotes( result );
+		return result;
 	}
 } // namespace daw::parse_template_impl
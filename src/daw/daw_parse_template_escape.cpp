@@ -0,0 +1,363 @@
+// The MIT License (MIT)
+//
+// Copyright (c) Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include <daw/daw_parse_template_escape.h>
+#include <daw/daw_parse_template_scan.h>
+
+#include <cstddef>
+#include <utility>
+
+#if defined( __x86_64__ ) or defined( _M_X64 )
+#define DAW_PARSE_TEMPLATE_X64
+#include <immintrin.h>
+#if defined( _MSC_VER ) and not defined( __clang__ )
+#include <intrin.h>
+#endif
+#endif
+
+#if defined( DAW_PARSE_TEMPLATE_X64 ) and ( defined( __GNUC__ ) or defined( __clang__ ) )
+#define DAW_TARGET_AVX2 __attribute__( ( target( "avx2" ) ) )
+#else
+#define DAW_TARGET_AVX2
+#endif
+
+namespace daw::parse_template_impl {
+	namespace {
+		constexpr auto npos = daw::string_view::npos;
+
+		constexpr bool is_html_special( unsigned char c ) noexcept {
+			return c == '&' or c == '<' or c == '>' or c == '"' or c == '\'';
+		}
+
+		constexpr bool needs_escape( unsigned char c, escape_mode mode ) noexcept {
+			switch( mode ) {
+			case escape_mode::none:
+				return false;
+			case escape_mode::html:
+				return is_html_special( c );
+			case escape_mode::attr:
+				return is_html_special( c ) or c == '`' or c == '=' or c <= 0x20U;
+			case escape_mode::url:
+				return not( ( c >= 'a' and c <= 'z' ) or ( c >= 'A' and c <= 'Z' ) or
+				            ( c >= '0' and c <= '9' ) or c == '-' or c == '.' or c == '_' or c == '~' );
+			case escape_mode::json:
+				return c == '"' or c == '\\' or c < 0x20U;
+			}
+			return false;
+		}
+
+		std::size_t find_escape_scalar( char const *first,
+		                                std::size_t pos,
+		                                std::size_t size,
+		                                escape_mode mode ) noexcept {
+			for( ; pos < size; ++pos ) {
+				if( needs_escape( static_cast<unsigned char>( first[pos] ), mode ) ) {
+					return pos;
+				}
+			}
+			return npos;
+		}
+
+#if defined( DAW_PARSE_TEMPLATE_X64 )
+		inline unsigned count_trailing_zeros( unsigned mask ) noexcept {
+#if defined( _MSC_VER ) and not defined( __clang__ )
+			unsigned long result = 0;
+			_BitScanForward( &result, mask );
+			return static_cast<unsigned>( result );
+#else
+			return static_cast<unsigned>( __builtin_ctz( mask ) );
+#endif
+		}
+
+		inline __m128i eq_sse2( __m128i a, char c ) noexcept {
+			return _mm_cmpeq_epi8( a, _mm_set1_epi8( c ) );
+		}
+
+		/// Bytes of a in [lo, hi], compared as unsigned
+		inline __m128i in_range_sse2( __m128i a, unsigned char lo, unsigned char hi ) noexcept {
+			auto const offset = _mm_sub_epi8( a, _mm_set1_epi8( static_cast<char>( lo ) ) );
+			auto const limit = _mm_set1_epi8( static_cast<char>( hi - lo ) );
+			return _mm_cmpeq_epi8( _mm_min_epu8( offset, limit ), offset );
+		}
+
+		inline __m128i html_sse2( __m128i a ) noexcept {
+			return _mm_or_si128(
+			  _mm_or_si128( _mm_or_si128( eq_sse2( a, '&' ), eq_sse2( a, '<' ) ),
+			                _mm_or_si128( eq_sse2( a, '>' ), eq_sse2( a, '"' ) ) ),
+			  eq_sse2( a, '\'' ) );
+		}
+
+		/// Bit n is set when byte n of a needs escaping
+		inline unsigned escape_mask_sse2( __m128i a, escape_mode mode ) noexcept {
+			auto matches = _mm_setzero_si128( );
+			switch( mode ) {
+			case escape_mode::none:
+				break;
+			case escape_mode::html:
+				matches = html_sse2( a );
+				break;
+			case escape_mode::attr:
+				matches = _mm_or_si128(
+				  _mm_or_si128( html_sse2( a ), in_range_sse2( a, 0, 0x20 ) ),
+				  _mm_or_si128( eq_sse2( a, '`' ), eq_sse2( a, '=' ) ) );
+				break;
+			case escape_mode::url: {
+				auto const lower = _mm_or_si128( a, _mm_set1_epi8( 0x20 ) );
+				auto const clean = _mm_or_si128(
+				  _mm_or_si128( in_range_sse2( lower, 'a', 'z' ), in_range_sse2( a, '0', '9' ) ),
+				  _mm_or_si128( _mm_or_si128( eq_sse2( a, '-' ), eq_sse2( a, '.' ) ),
+				                _mm_or_si128( eq_sse2( a, '_' ), eq_sse2( a, '~' ) ) ) );
+				matches = _mm_andnot_si128( clean, _mm_set1_epi8( -1 ) );
+				break;
+			}
+			case escape_mode::json:
+				matches = _mm_or_si128( _mm_or_si128( eq_sse2( a, '"' ), eq_sse2( a, '\\' ) ),
+				                        in_range_sse2( a, 0, 0x1F ) );
+				break;
+			}
+			return static_cast<unsigned>( _mm_movemask_epi8( matches ) );
+		}
+
+		// SSE2 is part of x86-64 so this needs no runtime check
+		std::size_t find_escape_sse2( char const *first, std::size_t size, escape_mode mode ) noexcept {
+			std::size_t pos = 0;
+			for( ; pos + 16 <= size; pos += 16 ) {
+				auto const a = _mm_loadu_si128( reinterpret_cast<__m128i const *>( first + pos ) );
+				auto const mask = escape_mask_sse2( a, mode );
+				if( mask != 0 ) {
+					return pos + count_trailing_zeros( mask );
+				}
+			}
+			return find_escape_scalar( first, pos, size, mode );
+		}
+
+		DAW_TARGET_AVX2 inline __m256i eq_avx2( __m256i a, char c ) noexcept {
+			return _mm256_cmpeq_epi8( a, _mm256_set1_epi8( c ) );
+		}
+
+		DAW_TARGET_AVX2 inline __m256i
+		in_range_avx2( __m256i a, unsigned char lo, unsigned char hi ) noexcept {
+			auto const offset = _mm256_sub_epi8( a, _mm256_set1_epi8( static_cast<char>( lo ) ) );
+			auto const limit = _mm256_set1_epi8( static_cast<char>( hi - lo ) );
+			return _mm256_cmpeq_epi8( _mm256_min_epu8( offset, limit ), offset );
+		}
+
+		DAW_TARGET_AVX2 inline __m256i html_avx2( __m256i a ) noexcept {
+			return _mm256_or_si256(
+			  _mm256_or_si256( _mm256_or_si256( eq_avx2( a, '&' ), eq_avx2( a, '<' ) ),
+			                   _mm256_or_si256( eq_avx2( a, '>' ), eq_avx2( a, '"' ) ) ),
+			  eq_avx2( a, '\'' ) );
+		}
+
+		DAW_TARGET_AVX2 inline unsigned escape_mask_avx2( __m256i a, escape_mode mode ) noexcept {
+			auto matches = _mm256_setzero_si256( );
+			switch( mode ) {
+			case escape_mode::none:
+				break;
+			case escape_mode::html:
+				matches = html_avx2( a );
+				break;
+			case escape_mode::attr:
+				matches = _mm256_or_si256(
+				  _mm256_or_si256( html_avx2( a ), in_range_avx2( a, 0, 0x20 ) ),
+				  _mm256_or_si256( eq_avx2( a, '`' ), eq_avx2( a, '=' ) ) );
+				break;
+			case escape_mode::url: {
+				auto const lower = _mm256_or_si256( a, _mm256_set1_epi8( 0x20 ) );
+				auto const clean = _mm256_or_si256(
+				  _mm256_or_si256( in_range_avx2( lower, 'a', 'z' ), in_range_avx2( a, '0', '9' ) ),
+				  _mm256_or_si256( _mm256_or_si256( eq_avx2( a, '-' ), eq_avx2( a, '.' ) ),
+				                   _mm256_or_si256( eq_avx2( a, '_' ), eq_avx2( a, '~' ) ) ) );
+				matches = _mm256_andnot_si256( clean, _mm256_set1_epi8( -1 ) );
+				break;
+			}
+			case escape_mode::json:
+				matches = _mm256_or_si256( _mm256_or_si256( eq_avx2( a, '"' ), eq_avx2( a, '\\' ) ),
+				                           in_range_avx2( a, 0, 0x1F ) );
+				break;
+			}
+			return static_cast<unsigned>( _mm256_movemask_epi8( matches ) );
+		}
+
+		DAW_TARGET_AVX2 std::size_t
+		find_escape_avx2( char const *first, std::size_t size, escape_mode mode ) noexcept {
+			std::size_t pos = 0;
+			for( ; pos + 32 <= size; pos += 32 ) {
+				auto const a = _mm256_loadu_si256( reinterpret_cast<__m256i const *>( first + pos ) );
+				auto const mask = escape_mask_avx2( a, mode );
+				if( mask != 0 ) {
+					return pos + count_trailing_zeros( mask );
+				}
+			}
+			return find_escape_scalar( first, pos, size, mode );
+		}
+#endif
+
+		constexpr char hex_digits[] = "0123456789ABCDEF";
+
+		/// The replacement for c, which mode escapes, written to buffer
+		daw::string_view
+		replacement( unsigned char c, escape_mode mode, char ( &buffer )[8] ) noexcept {
+			using namespace daw::string_view_literals;
+			switch( mode ) {
+			case escape_mode::html:
+			case escape_mode::attr:
+				switch( c ) {
+				case '&':
+					return "&amp;"_sv;
+				case '<':
+					return "&lt;"_sv;
+				case '>':
+					return "&gt;"_sv;
+				case '"':
+					return "&quot;"_sv;
+				case '\'':
+					return "&#39;"_sv;
+				default:
+					// &#xHH;
+					buffer[0] = '&';
+					buffer[1] = '#';
+					buffer[2] = 'x';
+					buffer[3] = hex_digits[c >> 4U];
+					buffer[4] = hex_digits[c & 0xFU];
+					buffer[5] = ';';
+					return daw::string_view( buffer, 6 );
+				}
+			case escape_mode::url:
+				buffer[0] = '%';
+				buffer[1] = hex_digits[c >> 4U];
+				buffer[2] = hex_digits[c & 0xFU];
+				return daw::string_view( buffer, 3 );
+			case escape_mode::json:
+				switch( c ) {
+				case '"':
+					return "\\\""_sv;
+				case '\\':
+					return "\\\\"_sv;
+				case '\b':
+					return "\\b"_sv;
+				case '\f':
+					return "\\f"_sv;
+				case '\n':
+					return "\\n"_sv;
+				case '\r':
+					return "\\r"_sv;
+				case '\t':
+					return "\\t"_sv;
+				default:
+					// \u00HH
+					buffer[0] = '\\';
+					buffer[1] = 'u';
+					buffer[2] = '0';
+					buffer[3] = '0';
+					buffer[4] = hex_digits[c >> 4U];
+					buffer[5] = hex_digits[c & 0xFU];
+					return daw::string_view( buffer, 6 );
+				}
+			case escape_mode::none:
+				break;
+			}
+			buffer[0] = static_cast<char>( c );
+			return daw::string_view( buffer, 1 );
+		}
+
+		thread_local std::string spare_escape_buffer{ };
+	} // namespace
+
+	std::optional<escape_mode> parse_escape_mode( daw::string_view name ) noexcept {
+		using namespace daw::string_view_literals;
+		if( name == "html"_sv ) {
+			return escape_mode::html;
+		}
+		if( name == "attr"_sv ) {
+			return escape_mode::attr;
+		}
+		if( name == "url"_sv ) {
+			return escape_mode::url;
+		}
+		if( name == "json"_sv ) {
+			return escape_mode::json;
+		}
+		if( name == "none"_sv ) {
+			return escape_mode::none;
+		}
+		return std::nullopt;
+	}
+
+	std::size_t find_escape( daw::string_view str, escape_mode mode ) noexcept {
+		if( mode == escape_mode::none ) {
+			return npos;
+		}
+		switch( active_simd_level( ) ) {
+#if defined( DAW_PARSE_TEMPLATE_X64 )
+		case simd_level::avx2:
+			return find_escape_avx2( str.data( ), str.size( ), mode );
+		case simd_level::sse2:
+			return find_escape_sse2( str.data( ), str.size( ), mode );
+#endif
+		default:
+			return find_escape_scalar( str.data( ), 0, str.size( ), mode );
+		}
+	}
+
+	daw::io::IOOpResult
+	write_escaped( daw::io::WriteProxy &writer, daw::string_view str, escape_mode mode ) {
+		auto result = daw::io::IOOpResult{ };
+		result.status = daw::io::IOOpStatus::Ok;
+		auto const write = [&]( daw::string_view part ) {
+			auto const wret = writer.write( part );
+			result.count += wret.count;
+			result.status = wret.status;
+			return wret.status == daw::io::IOOpStatus::Ok;
+		};
+		char buffer[8];
+		while( not str.empty( ) ) {
+			auto const pos = find_escape( str, mode );
+			if( pos == npos ) {
+				write( str );
+				break;
+			}
+			if( pos != 0 and not write( str.substr( 0, pos ) ) ) {
+				break;
+			}
+			if( not write( replacement( static_cast<unsigned char>( str[pos] ), mode, buffer ) ) ) {
+				break;
+			}
+			str.remove_prefix( pos + 1 );
+		}
+		return result;
+	}
+
+	std::string take_escape_buffer( ) {
+		auto result = std::move( spare_escape_buffer );
+		result.clear( );
+		return result;
+	}
+
+	void release_escape_buffer( std::string &&buffer ) noexcept {
+		// Keep the larger buffer when a nested render also took one
+		if( buffer.capacity( ) > spare_escape_buffer.capacity( ) ) {
+			spare_escape_buffer = std::move( buffer );
+		}
+	}
+} // namespace daw::parse_template_impl
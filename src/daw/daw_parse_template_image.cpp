@@ -0,0 +1,117 @@
+// The MIT License (MIT)
+//
+// Copyright (c) Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "daw/daw_parse_template_image.h"
+
+#include <daw/daw_string_view.h>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace daw::parse_template_impl {
+	namespace {
+		constexpr char image_magic[8] = { 'D', 'A', 'W', 'T', 'P', 'L', '\r', '\n' };
+		// Written as is, so it reads back differently on a machine with another byte order
+		constexpr std::uint32_t image_byte_order = 0x01020304U;
+
+		template<typename T>
+		void append_value( std::string &out, T value ) {
+			char buffer[sizeof( T )];
+			std::memcpy( buffer, &value, sizeof( T ) );
+			out.append( buffer, sizeof( T ) );
+		}
+
+		/// Read a T at pos, which the caller has checked is in bounds, and advance pos past it
+		template<typename T>
+		T read_value( char const *first, std::size_t &pos ) noexcept {
+			T result;
+			std::memcpy( &result, first + pos, sizeof( T ) );
+			pos += sizeof( T );
+			return result;
+		}
+	} // namespace
+
+	void append_image_header( std::string &out, image_header const &header ) {
+		out.append( image_magic, sizeof( image_magic ) );
+		append_value( out, image_version );
+		append_value( out, image_byte_order );
+		append_value( out, header.record_count );
+		append_value( out, header.text_size );
+		append_value( out, header.default_escape );
+		out.append( 3, '\0' );
+	}
+
+	void append_image_record( std::string &out, image_record const &record ) {
+		append_value( out, record.op );
+		append_value( out, record.escape );
+		out.append( 2, '\0' );
+		append_value( out, record.first.first );
+		append_value( out, record.first.size );
+		append_value( out, record.second.first );
+		append_value( out, record.second.size );
+		append_value( out, record.value );
+	}
+
+	daw::string_view read_image_header( daw::string_view image, image_header &header ) noexcept {
+		if( image.size( ) < image_header_size or
+		    std::memcmp( image.data( ), image_magic, sizeof( image_magic ) ) != 0 ) {
+			return "Not a template image";
+		}
+		auto pos = sizeof( image_magic );
+		if( read_value<std::uint32_t>( image.data( ), pos ) != image_version ) {
+			return "Unsupported template image version";
+		}
+		if( read_value<std::uint32_t>( image.data( ), pos ) != image_byte_order ) {
+			return "Template image was written with a different byte order";
+		}
+		header.record_count = read_value<std::uint32_t>( image.data( ), pos );
+		header.text_size = read_value<std::uint32_t>( image.data( ), pos );
+		header.default_escape = read_value<std::uint8_t>( image.data( ), pos );
+		auto const expected_size = std::uint64_t{ image_header_size } +
+		                           std::uint64_t{ header.record_count } * image_record_size +
+		                           header.text_size;
+		if( image.size( ) != expected_size ) {
+			return "Template image is truncated or has trailing data";
+		}
+		return { };
+	}
+
+	image_record read_image_record( daw::string_view image, std::size_t n ) noexcept {
+		auto pos = image_header_size + n * image_record_size;
+		auto result = image_record{ };
+		result.op = read_value<std::uint8_t>( image.data( ), pos );
+		result.escape = read_value<std::uint8_t>( image.data( ), pos );
+		pos += 2;
+		result.first.first = read_value<std::uint32_t>( image.data( ), pos );
+		result.first.size = read_value<std::uint32_t>( image.data( ), pos );
+		result.second.first = read_value<std::uint32_t>( image.data( ), pos );
+		result.second.size = read_value<std::uint32_t>( image.data( ), pos );
+		result.value = read_value<std::uint64_t>( image.data( ), pos );
+		return result;
+	}
+
+	daw::string_view read_image_text( daw::string_view image, image_header const &header ) noexcept {
+		return image.substr( image.size( ) - header.text_size );
+	}
+} // namespace daw::parse_template_impl
@@ -0,0 +1,244 @@
+// The MIT License (MIT)
+//
+// Copyright (c) Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include <daw/daw_parse_template_scan.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+
+#if defined( __x86_64__ ) or defined( _M_X64 )
+#define DAW_PARSE_TEMPLATE_X64
+#include <immintrin.h>
+#if defined( _MSC_VER ) and not defined( __clang__ )
+#include <intrin.h>
+#endif
+#endif
+
+#if defined( DAW_PARSE_TEMPLATE_X64 ) and ( defined( __GNUC__ ) or defined( __clang__ ) )
+#define DAW_TARGET_AVX2 __attribute__( ( target( "avx2" ) ) )
+#else
+#define DAW_TARGET_AVX2
+#endif
+
+namespace daw::parse_template_impl {
+	namespace {
+		constexpr auto npos = daw::string_view::npos;
+
+		// Scalar versions, also used for the tails the vector versions cannot load a full block for
+		std::size_t find_pair_scalar( char const *first,
+		                              std::size_t pos,
+		                              std::size_t size,
+		                              char c0,
+		                              char c1 ) noexcept {
+			while( pos + 1 < size ) {
+				auto const *p =
+				  static_cast<char const *>( std::memchr( first + pos, c0, size - pos - 1 ) );
+				if( p == nullptr ) {
+					return npos;
+				}
+				pos = static_cast<std::size_t>( p - first );
+				if( first[pos + 1] == c1 ) {
+					return pos;
+				}
+				++pos;
+			}
+			return npos;
+		}
+
+		std::size_t find_first_of_scalar( char const *first,
+		                                  std::size_t pos,
+		                                  std::size_t size,
+		                                  char c0,
+		                                  char c1,
+		                                  char c2 ) noexcept {
+			for( ; pos < size; ++pos ) {
+				auto const c = first[pos];
+				if( c == c0 or c == c1 or c == c2 ) {
+					return pos;
+				}
+			}
+			return npos;
+		}
+
+#if defined( DAW_PARSE_TEMPLATE_X64 )
+		inline unsigned count_trailing_zeros( unsigned mask ) noexcept {
+#if defined( _MSC_VER ) and not defined( __clang__ )
+			unsigned long result = 0;
+			_BitScanForward( &result, mask );
+			return static_cast<unsigned>( result );
+#else
+			return static_cast<unsigned>( __builtin_ctz( mask ) );
+#endif
+		}
+
+		// SSE2 is part of x86-64 so these need no runtime check
+		std::size_t find_pair_sse2( char const *first, std::size_t size, char c0, char c1 ) noexcept {
+			auto const v0 = _mm_set1_epi8( c0 );
+			auto const v1 = _mm_set1_epi8( c1 );
+			std::size_t pos = 0;
+			// The second load is one byte ahead, so it needs one byte past the block
+			for( ; pos + 17 <= size; pos += 16 ) {
+				auto const a = _mm_loadu_si128( reinterpret_cast<__m128i const *>( first + pos ) );
+				auto const b = _mm_loadu_si128( reinterpret_cast<__m128i const *>( first + pos + 1 ) );
+				auto const mask = static_cast<unsigned>(
+				  _mm_movemask_epi8( _mm_and_si128( _mm_cmpeq_epi8( a, v0 ), _mm_cmpeq_epi8( b, v1 ) ) ) );
+				if( mask != 0 ) {
+					return pos + count_trailing_zeros( mask );
+				}
+			}
+			return find_pair_scalar( first, pos, size, c0, c1 );
+		}
+
+		std::size_t
+		find_first_of_sse2( char const *first, std::size_t size, char c0, char c1, char c2 ) noexcept {
+			auto const v0 = _mm_set1_epi8( c0 );
+			auto const v1 = _mm_set1_epi8( c1 );
+			auto const v2 = _mm_set1_epi8( c2 );
+			std::size_t pos = 0;
+			for( ; pos + 16 <= size; pos += 16 ) {
+				auto const a = _mm_loadu_si128( reinterpret_cast<__m128i const *>( first + pos ) );
+				auto const eq =
+				  _mm_or_si128( _mm_or_si128( _mm_cmpeq_epi8( a, v0 ), _mm_cmpeq_epi8( a, v1 ) ),
+				                _mm_cmpeq_epi8( a, v2 ) );
+				auto const mask = static_cast<unsigned>( _mm_movemask_epi8( eq ) );
+				if( mask != 0 ) {
+					return pos + count_trailing_zeros( mask );
+				}
+			}
+			return find_first_of_scalar( first, pos, size, c0, c1, c2 );
+		}
+
+		DAW_TARGET_AVX2 std::size_t
+		find_pair_avx2( char const *first, std::size_t size, char c0, char c1 ) noexcept {
+			auto const v0 = _mm256_set1_epi8( c0 );
+			auto const v1 = _mm256_set1_epi8( c1 );
+			std::size_t pos = 0;
+			for( ; pos + 33 <= size; pos += 32 ) {
+				auto const a = _mm256_loadu_si256( reinterpret_cast<__m256i const *>( first + pos ) );
+				auto const b = _mm256_loadu_si256( reinterpret_cast<__m256i const *>( first + pos + 1 ) );
+				auto const mask = static_cast<unsigned>( _mm256_movemask_epi8(
+				  _mm256_and_si256( _mm256_cmpeq_epi8( a, v0 ), _mm256_cmpeq_epi8( b, v1 ) ) ) );
+				if( mask != 0 ) {
+					return pos + count_trailing_zeros( mask );
+				}
+			}
+			return find_pair_scalar( first, pos, size, c0, c1 );
+		}
+
+		DAW_TARGET_AVX2 std::size_t
+		find_first_of_avx2( char const *first, std::size_t size, char c0, char c1, char c2 ) noexcept {
+			auto const v0 = _mm256_set1_epi8( c0 );
+			auto const v1 = _mm256_set1_epi8( c1 );
+			auto const v2 = _mm256_set1_epi8( c2 );
+			std::size_t pos = 0;
+			for( ; pos + 32 <= size; pos += 32 ) {
+				auto const a = _mm256_loadu_si256( reinterpret_cast<__m256i const *>( first + pos ) );
+				auto const eq = _mm256_or_si256(
+				  _mm256_or_si256( _mm256_cmpeq_epi8( a, v0 ), _mm256_cmpeq_epi8( a, v1 ) ),
+				  _mm256_cmpeq_epi8( a, v2 ) );
+				auto const mask = static_cast<unsigned>( _mm256_movemask_epi8( eq ) );
+				if( mask != 0 ) {
+					return pos + count_trailing_zeros( mask );
+				}
+			}
+			return find_first_of_scalar( first, pos, size, c0, c1, c2 );
+		}
+
+		bool cpu_has_avx2( ) noexcept {
+#if defined( _MSC_VER ) and not defined( __clang__ )
+			int regs[4]{ };
+			__cpuid( regs, 0 );
+			if( regs[0] < 7 ) {
+				return false;
+			}
+			__cpuid( regs, 1 );
+			// The OS must save the YMM registers, checked through OSXSAVE and XCR0
+			bool const os_saves_ymm =
+			  ( regs[2] & ( 1 << 27 ) ) != 0 and ( _xgetbv( 0 ) & 0x6 ) == 0x6;
+			if( not os_saves_ymm ) {
+				return false;
+			}
+			__cpuidex( regs, 7, 0 );
+			return ( regs[1] & ( 1 << 5 ) ) != 0;
+#else
+			__builtin_cpu_init( );
+			return __builtin_cpu_supports( "avx2" );
+#endif
+		}
+#endif
+
+		simd_level detect_simd_level( ) noexcept {
+#if defined( DAW_PARSE_TEMPLATE_X64 )
+			return cpu_has_avx2( ) ? simd_level::avx2 : simd_level::sse2;
+#else
+			return simd_level::scalar;
+#endif
+		}
+
+		simd_level const best_simd_level = detect_simd_level( );
+		std::atomic<simd_level> current_simd_level{ best_simd_level };
+	} // namespace
+
+	simd_level active_simd_level( ) noexcept {
+		return current_simd_level.load( std::memory_order_relaxed );
+	}
+
+	simd_level supported_simd_level( ) noexcept {
+		return best_simd_level;
+	}
+
+	simd_level set_simd_level( simd_level level ) noexcept {
+		if( static_cast<int>( level ) > static_cast<int>( best_simd_level ) ) {
+			level = best_simd_level;
+		}
+		current_simd_level.store( level, std::memory_order_relaxed );
+		return level;
+	}
+
+	std::size_t find_pair( daw::string_view str, char c0, char c1 ) noexcept {
+		switch( active_simd_level( ) ) {
+#if defined( DAW_PARSE_TEMPLATE_X64 )
+		case simd_level::avx2:
+			return find_pair_avx2( str.data( ), str.size( ), c0, c1 );
+		case simd_level::sse2:
+			return find_pair_sse2( str.data( ), str.size( ), c0, c1 );
+#endif
+		default:
+			return find_pair_scalar( str.data( ), 0, str.size( ), c0, c1 );
+		}
+	}
+
+	std::size_t find_first_of( daw::string_view str, char c0, char c1, char c2 ) noexcept {
+		switch( active_simd_level( ) ) {
+#if defined( DAW_PARSE_TEMPLATE_X64 )
+		case simd_level::avx2:
+			return find_first_of_avx2( str.data( ), str.size( ), c0, c1, c2 );
+		case simd_level::sse2:
+			return find_first_of_sse2( str.data( ), str.size( ), c0, c1, c2 );
+#endif
+		default:
+			return find_first_of_scalar( str.data( ), 0, str.size( ), c0, c1, c2 );
+		}
+	}
+} // namespace daw::parse_template_impl
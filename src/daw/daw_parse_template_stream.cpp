@@ -0,0 +1,109 @@
+// The MIT License (MIT)
+//
+// Copyright (c) Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include <daw/daw_parse_template_stream.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <ios>
+
+namespace daw {
+	void chunked_stream::reset( ) {
+		m_result = chunked_stream_result{ };
+		setp( m_buffer.data( ), m_buffer.data( ) + m_buffer.size( ) );
+	}
+
+	bool chunked_stream::flush( ) {
+		if( m_result.stopped ) {
+			// Output after a stop is discarded
+			setp( m_buffer.data( ), m_buffer.data( ) + m_buffer.size( ) );
+			return false;
+		}
+		auto const size = static_cast<std::size_t>( pptr( ) - pbase( ) );
+		if( size == 0 ) {
+			return true;
+		}
+		setp( m_buffer.data( ), m_buffer.data( ) + m_buffer.size( ) );
+		m_result.bytes += size;
+		++m_result.chunks;
+		if( m_sink( daw::string_view( m_buffer.data( ), size ) ) == stream_status::stop ) {
+			m_result.stopped = true;
+			return false;
+		}
+		return true;
+	}
+
+	void chunked_stream::note_pending( ) {
+		if( m_max_latency.count( ) > 0 and pptr( ) == pbase( ) ) {
+			m_first_pending = std::chrono::steady_clock::now( );
+		}
+	}
+
+	void chunked_stream::flush_if_stale( ) {
+		if( m_max_latency.count( ) > 0 and pptr( ) != pbase( ) and
+		    std::chrono::steady_clock::now( ) - m_first_pending >= m_max_latency ) {
+			flush( );
+		}
+	}
+
+	chunked_stream::int_type chunked_stream::overflow( int_type ch ) {
+		if( not flush( ) ) {
+			// Report success so the render is not treated as an error, the render control ends it
+			return traits_type::not_eof( ch );
+		}
+		if( not traits_type::eq_int_type( ch, traits_type::eof( ) ) ) {
+			note_pending( );
+			*pptr( ) = traits_type::to_char_type( ch );
+			pbump( 1 );
+		}
+		return traits_type::not_eof( ch );
+	}
+
+	std::streamsize chunked_stream::xsputn( char const *s, std::streamsize count ) {
+		auto remaining = static_cast<std::size_t>( count );
+		while( remaining > 0 ) {
+			if( m_result.stopped ) {
+				break;
+			}
+			auto const space = static_cast<std::size_t>( epptr( ) - pptr( ) );
+			if( space == 0 ) {
+				flush( );
+				continue;
+			}
+			note_pending( );
+			auto const n = std::min( space, remaining );
+			std::memcpy( pptr( ), s, n );
+			// pbump takes an int, n is at most the buffer size
+			pbump( static_cast<int>( n ) );
+			s += n;
+			remaining -= n;
+		}
+		flush_if_stale( );
+		return count;
+	}
+
+	int chunked_stream::sync( ) {
+		return flush( ) ? 0 : -1;
+	}
+} // namespace daw
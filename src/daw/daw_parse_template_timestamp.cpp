@@ -0,0 +1,545 @@
+// The MIT License (MIT)
+//
+// Copyright (c) Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "daw/daw_parse_template_timestamp.h"
+
+#include <daw/daw_string_view.h>
+
+#include <date/date.h>
+#include <date/tz.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <iterator>
+#include <locale>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+namespace daw::parse_template_impl {
+	namespace {
+		constexpr char const digit_pairs[] = "00010203040506070809"
+		                                     "10111213141516171819"
+		                                     "20212223242526272829"
+		                                     "30313233343536373839"
+		                                     "40414243444546474849"
+		                                     "50515253545556575859"
+		                                     "60616263646566676869"
+		                                     "70717273747576777879"
+		                                     "80818283848586878889"
+		                                     "90919293949596979899";
+
+		constexpr std::array<daw::string_view, 7> weekday_names = {
+		  "Sunday", "Monday", "Tuesday", "Wednesday", "Thursday", "Friday", "Saturday" };
+
+		constexpr std::array<daw::string_view, 12> month_names = { "January",
+		                                                           "February",
+		                                                           "March",
+		                                                           "April",
+		                                                           "May",
+		                                                           "June",
+		                                                           "July",
+		                                                           "August",
+		                                                           "September",
+		                                                           "October",
+		                                                           "November",
+		                                                           "December" };
+
+		// See http://howardhinnant.github.io/date_algorithms.html
+		constexpr std::int64_t days_from_civil( std::int64_t y, unsigned m, unsigned d ) noexcept {
+			y -= m <= 2 ? 1 : 0;
+			auto const era = ( y >= 0 ? y : y - 399 ) / 400;
+			auto const yoe = static_cast<unsigned>( y - era * 400 );
+			auto const doy = ( 153 * ( m > 2 ? m - 3 : m + 9 ) + 2 ) / 5 + d - 1;
+			auto const doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+			return era * 146097 + static_cast<std::int64_t>( doe ) - 719468;
+		}
+
+		struct civil_date {
+			std::int64_t year;
+			unsigned month;
+			unsigned day;
+		};
+
+		constexpr civil_date civil_from_days( std::int64_t z ) noexcept {
+			z += 719468;
+			auto const era = ( z >= 0 ? z : z - 146096 ) / 146097;
+			auto const doe = static_cast<unsigned>( z - era * 146097 );
+			auto const yoe = ( doe - doe / 1460 + doe / 36524 - doe / 146096 ) / 365;
+			auto const doy = doe - ( 365 * yoe + yoe / 4 - yoe / 100 );
+			auto const mp = ( 5 * doy + 2 ) / 153;
+			auto const d = doy - ( 153 * mp + 2 ) / 5 + 1;
+			auto const m = mp < 10 ? mp + 3 : mp - 9;
+			auto const y = static_cast<std::int64_t>( yoe ) + era * 400 + ( m <= 2 ? 1 : 0 );
+			return civil_date{ y, m, d };
+		}
+
+		// Sunday is 0
+		constexpr unsigned weekday_from_days( std::int64_t z ) noexcept {
+			return static_cast<unsigned>( z >= -4 ? ( z + 4 ) % 7 : ( z + 5 ) % 7 + 6 );
+		}
+
+		constexpr std::int64_t floor_div( std::int64_t x, std::int64_t y ) noexcept {
+			auto const q = x / y;
+			return ( x % y != 0 and ( ( x < 0 ) != ( y < 0 ) ) ) ? q - 1 : q;
+		}
+
+		/// The values needed by the fields, computed once per format call
+		struct broken_down_time {
+			civil_date date;
+			std::int64_t iso_year;
+			unsigned day_of_year; // Jan 1 is 0
+			unsigned weekday;     // Sunday is 0
+			unsigned iso_week;
+			unsigned hour;
+			unsigned minute;
+			unsigned second;
+		};
+
+		broken_down_time break_down( std::int64_t local_seconds ) noexcept {
+			auto const days = floor_div( local_seconds, 86400 );
+			auto const time_of_day = static_cast<unsigned>( local_seconds - days * 86400 );
+			auto result = broken_down_time{ };
+			result.date = civil_from_days( days );
+			result.day_of_year =
+			  static_cast<unsigned>( days - days_from_civil( result.date.year, 1, 1 ) );
+			result.weekday = weekday_from_days( days );
+			// The ISO week belongs to the year that its Thursday is in
+			auto const days_since_monday = ( result.weekday + 6 ) % 7;
+			auto const thursday = days - days_since_monday + 3;
+			result.iso_year = civil_from_days( thursday ).year;
+			result.iso_week =
+			  static_cast<unsigned>( ( thursday - days_from_civil( result.iso_year, 1, 1 ) ) / 7 + 1 );
+			result.hour = time_of_day / 3600;
+			result.minute = ( time_of_day % 3600 ) / 60;
+			result.second = time_of_day % 60;
+			return result;
+		}
+
+		class buffer_writer {
+			char *m_out;
+			std::size_t m_capacity;
+			std::size_t m_size = 0;
+			bool m_overflow = false;
+
+		public:
+			constexpr buffer_writer( char *out, std::size_t capacity ) noexcept
+			  : m_out( out )
+			  , m_capacity( capacity ) {}
+
+			void put( char c ) noexcept {
+				if( m_size >= m_capacity ) {
+					m_overflow = true;
+					return;
+				}
+				m_out[m_size++] = c;
+			}
+
+			void put( daw::string_view str ) noexcept {
+				if( m_capacity - m_size < str.size( ) ) {
+					m_overflow = true;
+					return;
+				}
+				std::memcpy( m_out + m_size, str.data( ), str.size( ) );
+				m_size += str.size( );
+			}
+
+			// value must be less than 100
+			void put2( unsigned value ) noexcept {
+				put( daw::string_view( digit_pairs + value * 2, 2 ) );
+			}
+
+			// value must be less than 10000
+			void put4( unsigned value ) noexcept {
+				put2( value / 100 );
+				put2( value % 100 );
+			}
+
+			[[nodiscard]] std::size_t size( ) const noexcept {
+				return m_overflow ? timestamp_formatter::npos : m_size;
+			}
+		};
+
+		// The first/last weeks of a year can be numbered from the prior/following Sunday or Monday
+		constexpr unsigned week_of_year( unsigned day_of_year, unsigned days_since_week_start ) {
+			return ( day_of_year + 7 - days_since_week_start ) / 7;
+		}
+	} // namespace
+
+	void timestamp_formatter::add_literal( daw::string_view str ) {
+		auto const first = static_cast<std::uint32_t>( m_literals.size( ) );
+		m_literals.append( str.data( ), str.size( ) );
+		if( not m_steps.empty( ) and m_steps.back( ).kind == field::literal ) {
+			m_steps.back( ).size += static_cast<std::uint32_t>( str.size( ) );
+			return;
+		}
+		m_steps.push_back( step{ field::literal, first, static_cast<std::uint32_t>( str.size( ) ) } );
+	}
+
+	void timestamp_formatter::add_field( field kind ) {
+		m_steps.push_back( step{ kind } );
+	}
+
+	timestamp_formatter::timestamp_formatter( daw::string_view fmt )
+	  : m_fmt( static_cast<std::string>( fmt ) ) {
+		// Names and AM/PM come from the locale in date::format
+		if( std::locale( ) != std::locale::classic( ) ) {
+			m_uses_fallback = true;
+			return;
+		}
+		while( not fmt.empty( ) ) {
+			auto literal = fmt.pop_front_until( '%', nodiscard );
+			if( not literal.empty( ) ) {
+				add_literal( literal );
+			}
+			if( fmt.empty( ) ) {
+				break;
+			}
+			fmt.remove_prefix( );
+			if( fmt.empty( ) ) {
+				m_uses_fallback = true;
+				return;
+			}
+			auto specifier = fmt.pop_front( );
+			bool const is_modified = specifier == 'E' or specifier == 'O';
+			if( is_modified ) {
+				if( fmt.empty( ) ) {
+					m_uses_fallback = true;
+					return;
+				}
+				specifier = fmt.pop_front( );
+				if( specifier != 'z' ) {
+					// The alternative representations come from the locale
+					m_uses_fallback = true;
+					return;
+				}
+			}
+			switch( specifier ) {
+			case 'a':
+				add_field( field::weekday_abbrev );
+				break;
+			case 'A':
+				add_field( field::weekday_name );
+				break;
+			case 'b':
+			case 'h':
+				add_field( field::month_abbrev );
+				break;
+			case 'B':
+				add_field( field::month_name );
+				break;
+			case 'C':
+				add_field( field::century );
+				break;
+			case 'd':
+				add_field( field::day );
+				break;
+			case 'D':
+				add_field( field::month );
+				add_literal( "/" );
+				add_field( field::day );
+				add_literal( "/" );
+				add_field( field::year2 );
+				break;
+			case 'e':
+				add_field( field::day_space_padded );
+				break;
+			case 'F':
+				add_field( field::year );
+				add_literal( "-" );
+				add_field( field::month );
+				add_literal( "-" );
+				add_field( field::day );
+				break;
+			case 'g':
+				add_field( field::iso_year2 );
+				break;
+			case 'G':
+				add_field( field::iso_year );
+				break;
+			case 'H':
+				add_field( field::hour );
+				break;
+			case 'I':
+				add_field( field::hour12 );
+				break;
+			case 'j':
+				add_field( field::day_of_year );
+				break;
+			case 'm':
+				add_field( field::month );
+				break;
+			case 'M':
+				add_field( field::minute );
+				break;
+			case 'n':
+				add_literal( "\n" );
+				break;
+			case 'p':
+				add_field( field::am_pm );
+				break;
+			case 'R':
+				add_field( field::hour );
+				add_literal( ":" );
+				add_field( field::minute );
+				break;
+			case 'S':
+				add_field( field::second );
+				break;
+			case 't':
+				add_literal( "\t" );
+				break;
+			case 'T':
+				add_field( field::hour );
+				add_literal( ":" );
+				add_field( field::minute );
+				add_literal( ":" );
+				add_field( field::second );
+				break;
+			case 'u':
+				add_field( field::iso_weekday );
+				break;
+			case 'U':
+				add_field( field::week_of_year_sunday );
+				break;
+			case 'V':
+				add_field( field::iso_week_of_year );
+				break;
+			case 'w':
+				add_field( field::weekday );
+				break;
+			case 'W':
+				add_field( field::week_of_year_monday );
+				break;
+			case 'y':
+				add_field( field::year2 );
+				break;
+			case 'Y':
+				add_field( field::year );
+				break;
+			case 'z':
+				add_field( is_modified ? field::utc_offset_colon : field::utc_offset );
+				break;
+			case 'Z':
+				add_field( field::tz_abbrev );
+				break;
+			case '%':
+				add_literal( "%" );
+				break;
+			default:
+				// %c, %r, %x, and %X are locale and platform dependent
+				m_uses_fallback = true;
+				return;
+			}
+		}
+	}
+
+	std::size_t timestamp_formatter::format_to( char *out,
+	                                            std::size_t capacity,
+	                                            date::sys_seconds tp,
+	                                            date::sys_info const &info ) const {
+		if( m_uses_fallback ) {
+			return npos;
+		}
+		auto const local_seconds =
+		  static_cast<std::int64_t>( tp.time_since_epoch( ).count( ) ) +
+		  static_cast<std::int64_t>(
+		    std::chrono::duration_cast<std::chrono::seconds>( info.offset ).count( ) );
+		auto const tm = break_down( local_seconds );
+		if( tm.date.year < 0 or tm.date.year > 9999 or tm.iso_year < 0 or tm.iso_year > 9999 ) {
+			return npos;
+		}
+		auto const year = static_cast<unsigned>( tm.date.year );
+		auto const iso_year = static_cast<unsigned>( tm.iso_year );
+
+		auto writer = buffer_writer( out, capacity );
+		for( auto const &s : m_steps ) {
+			switch( s.kind ) {
+			case field::literal:
+				writer.put( daw::string_view( m_literals.data( ) + s.first, s.size ) );
+				break;
+			case field::year:
+				writer.put4( year );
+				break;
+			case field::year2:
+				writer.put2( year % 100 );
+				break;
+			case field::century:
+				writer.put2( year / 100 );
+				break;
+			case field::iso_year:
+				writer.put4( iso_year );
+				break;
+			case field::iso_year2:
+				writer.put2( iso_year % 100 );
+				break;
+			case field::month:
+				writer.put2( tm.date.month );
+				break;
+			case field::month_name:
+				writer.put( month_names[tm.date.month - 1] );
+				break;
+			case field::month_abbrev:
+				writer.put( month_names[tm.date.month - 1].substr( 0, 3 ) );
+				break;
+			case field::day:
+				writer.put2( tm.date.day );
+				break;
+			case field::day_space_padded:
+				if( tm.date.day < 10 ) {
+					writer.put( ' ' );
+					writer.put( static_cast<char>( '0' + tm.date.day ) );
+				} else {
+					writer.put2( tm.date.day );
+				}
+				break;
+			case field::day_of_year:
+				writer.put( static_cast<char>( '0' + ( tm.day_of_year + 1 ) / 100 ) );
+				writer.put2( ( tm.day_of_year + 1 ) % 100 );
+				break;
+			case field::weekday:
+				writer.put( static_cast<char>( '0' + tm.weekday ) );
+				break;
+			case field::iso_weekday:
+				writer.put( static_cast<char>( '0' + ( tm.weekday == 0 ? 7 : tm.weekday ) ) );
+				break;
+			case field::weekday_name:
+				writer.put( weekday_names[tm.weekday] );
+				break;
+			case field::weekday_abbrev:
+				writer.put( weekday_names[tm.weekday].substr( 0, 3 ) );
+				break;
+			case field::week_of_year_sunday:
+				writer.put2( week_of_year( tm.day_of_year, tm.weekday ) );
+				break;
+			case field::week_of_year_monday:
+				writer.put2( week_of_year( tm.day_of_year, ( tm.weekday + 6 ) % 7 ) );
+				break;
+			case field::iso_week_of_year:
+				writer.put2( tm.iso_week );
+				break;
+			case field::hour:
+				writer.put2( tm.hour );
+				break;
+			case field::hour12:
+				writer.put2( tm.hour % 12 == 0 ? 12 : tm.hour % 12 );
+				break;
+			case field::am_pm:
+				writer.put( tm.hour < 12 ? "AM" : "PM" );
+				break;
+			case field::minute:
+				writer.put2( tm.minute );
+				break;
+			case field::second:
+				writer.put2( tm.second );
+				break;
+			case field::utc_offset:
+			case field::utc_offset_colon: {
+				auto offset =
+				  std::chrono::duration_cast<std::chrono::minutes>( info.offset ).count( );
+				writer.put( offset < 0 ? '-' : '+' );
+				offset = offset < 0 ? -offset : offset;
+				writer.put2( static_cast<unsigned>( ( offset / 60 ) % 100 ) );
+				if( s.kind == field::utc_offset_colon ) {
+					writer.put( ':' );
+				}
+				writer.put2( static_cast<unsigned>( offset % 60 ) );
+				break;
+			}
+			case field::tz_abbrev:
+				writer.put( info.abbrev );
+				break;
+			}
+		}
+		return writer.size( );
+	}
+
+	std::string timestamp_formatter::format( date::time_zone const *tz, date::sys_seconds tp ) const {
+		if( not m_uses_fallback ) {
+			auto buffer = std::array<char, 256>{ };
+			auto const size = format_to( buffer.data( ), buffer.size( ), tp, tz->get_info( tp ) );
+			if( size != npos ) {
+				return std::string( buffer.data( ), size );
+			}
+		}
+		return date::format( m_fmt, date::make_zoned( tz, tp ) );
+	}
+
+	namespace {
+		// The span of the transitions computed when a zone is resolved
+		constexpr auto transition_history = std::chrono::hours( 24 * 366 );
+		constexpr auto transition_horizon = std::chrono::hours( 24 * 366 * 20 );
+		// Far more than any zone has in the span, in case the database has a zone that changes often
+		constexpr std::size_t max_transitions = 512;
+	} // namespace
+
+	resolved_zone::resolved_zone( date::time_zone const *tz, std::string name )
+	  : m_tz( tz )
+	  , m_name( std::move( name ) ) {
+		using namespace std::chrono;
+		auto const now = floor<seconds>( system_clock::now( ) );
+		auto tp = date::sys_seconds( now - transition_history );
+		auto const last = date::sys_seconds( now + transition_horizon );
+		while( tp < last and m_transitions.size( ) < max_transitions ) {
+			auto info = m_tz->get_info( tp );
+			if( info.end <= tp ) {
+				break;
+			}
+			tp = info.end;
+			m_transitions.push_back( std::move( info ) );
+		}
+	}
+
+	date::sys_info const &resolved_zone::info( date::sys_seconds tp,
+	                                           date::sys_info &fallback ) const {
+		auto const pos = std::upper_bound( m_transitions.begin( ),
+		                                   m_transitions.end( ),
+		                                   tp,
+		                                   []( date::sys_seconds t, date::sys_info const &transition ) {
+			                                   return t < transition.begin;
+		                                   } );
+		if( pos != m_transitions.begin( ) and tp < std::prev( pos )->end ) {
+			return *std::prev( pos );
+		}
+		fallback = m_tz->get_info( tp );
+		return fallback;
+	}
+
+	resolved_zone const &resolve_zone( daw::string_view name ) {
+		static std::mutex zones_mutex{ };
+		static std::map<std::string, std::unique_ptr<resolved_zone>, std::less<>> zones{ };
+
+		auto const lock = std::lock_guard<std::mutex>( zones_mutex );
+		auto pos = zones.find( static_cast<std::string_view>( name ) );
+		if( pos == zones.end( ) ) {
+			auto const *tz = name.empty( ) ? date::current_zone( )
+			                               : date::locate_zone( static_cast<std::string>( name ) );
+			auto zone = std::make_unique<resolved_zone>( tz, static_cast<std::string>( name ) );
+			pos = zones.emplace( static_cast<std::string>( name ), std::move( zone ) ).first;
+		}
+		return *pos->second;
+	}
+} // namespace daw::parse_template_impl
@@ -0,0 +1,91 @@
+// The MIT License (MIT)
+//
+// Copyright (c) Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include <daw/daw_parse_template_writev.h>
+
+#if defined( DAW_PARSE_TEMPLATE_HAS_WRITEV )
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+#include <system_error>
+#include <vector>
+
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace daw {
+	namespace {
+#if defined( IOV_MAX )
+		constexpr std::size_t iov_max = IOV_MAX;
+#else
+		// POSIX guarantees at least 16, 1024 is the value on Linux and the BSDs
+		constexpr std::size_t iov_max = 1024;
+#endif
+	} // namespace
+
+	std::size_t write_to_fd( int fd, scatter_gather_output const &output, std::error_code &ec ) {
+		ec.clear( );
+		auto iovs = std::vector<iovec>( );
+		iovs.reserve( output.segment_count( ) );
+		output.for_each_segment( [&]( daw::string_view sv ) {
+			if( not sv.empty( ) ) {
+				iovs.push_back( iovec{ const_cast<char *>( sv.data( ) ), sv.size( ) } );
+			}
+		} );
+
+		std::size_t written = 0;
+		iovec *first = iovs.data( );
+		iovec *const last = iovs.data( ) + iovs.size( );
+		while( first != last ) {
+			auto const count = std::min( static_cast<std::size_t>( last - first ), iov_max );
+			auto const result = ::writev( fd, first, static_cast<int>( count ) );
+			if( result < 0 ) {
+				if( errno == EINTR ) {
+					continue;
+				}
+				ec = std::error_code( errno, std::generic_category( ) );
+				return written;
+			}
+			if( result == 0 ) {
+				ec = std::make_error_code( std::errc::io_error );
+				return written;
+			}
+			auto remaining = static_cast<std::size_t>( result );
+			written += remaining;
+			// Skip the segments that were fully written and trim the one that was partially written
+			while( first != last and remaining >= first->iov_len ) {
+				remaining -= first->iov_len;
+				++first;
+			}
+			if( remaining > 0 ) {
+				first->iov_base = static_cast<char *>( first->iov_base ) + remaining;
+				first->iov_len -= remaining;
+			}
+		}
+		return written;
+	}
+} // namespace daw
+
+#endif
@@ -0,0 +1,176 @@
+// The MIT License (MIT)
+//
+// Copyright (c) Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "daw/daw_render_profile.h"
+
+#include <cstdio>
+#include <string>
+
+namespace daw {
+	namespace {
+		std::size_t bucket_for( std::uint64_t ns ) noexcept {
+			std::size_t bucket = 0;
+			while( bucket + 1 < render_profile::bucket_count and
+			       ns >= render_profile::bucket_limit( bucket ) ) {
+				++bucket;
+			}
+			return bucket;
+		}
+
+		void append_json_string( std::string &out, daw::string_view str ) {
+			out += '"';
+			for( char c : str ) {
+				switch( c ) {
+				case '"':
+					out += "\\\"";
+					break;
+				case '\\':
+					out += "\\\\";
+					break;
+				case '\n':
+					out += "\\n";
+					break;
+				case '\t':
+					out += "\\t";
+					break;
+				default:
+					if( static_cast<unsigned char>( c ) < 0x20U ) {
+						char buff[7];
+						std::snprintf( buff, sizeof( buff ), "\\u%04x", static_cast<unsigned>( c ) );
+						out += buff;
+					} else {
+						out += c;
+					}
+				}
+			}
+			out += '"';
+		}
+	} // namespace
+
+	render_profile::render_profile( std::vector<tag> tags )
+	  : m_tags( std::move( tags ) )
+	  , m_counters( std::make_unique<counters[]>( m_tags.size( ) ) ) {}
+
+	void render_profile::record( std::size_t tag_index,
+	                             std::chrono::nanoseconds elapsed,
+	                             std::size_t bytes,
+	                             bool failed ) noexcept {
+		auto &c = m_counters[tag_index];
+		auto const ns = elapsed.count( ) > 0 ? static_cast<std::uint64_t>( elapsed.count( ) ) : 0U;
+		c.calls.fetch_add( 1, std::memory_order_relaxed );
+		if( failed ) {
+			c.errors.fetch_add( 1, std::memory_order_relaxed );
+		}
+		c.bytes.fetch_add( bytes, std::memory_order_relaxed );
+		c.total_ns.fetch_add( ns, std::memory_order_relaxed );
+		c.histogram[bucket_for( ns )].fetch_add( 1, std::memory_order_relaxed );
+	}
+
+	std::vector<render_profile::tag_counters> render_profile::snapshot( ) const {
+		auto result = std::vector<tag_counters>( );
+		result.reserve( m_tags.size( ) );
+		for( std::size_t n = 0; n < m_tags.size( ); ++n ) {
+			auto const &c = m_counters[n];
+			auto &item = result.emplace_back( );
+			item.tag = m_tags[n];
+			item.calls = c.calls.load( std::memory_order_relaxed );
+			item.errors = c.errors.load( std::memory_order_relaxed );
+			item.bytes = c.bytes.load( std::memory_order_relaxed );
+			item.total_ns = c.total_ns.load( std::memory_order_relaxed );
+			for( std::size_t b = 0; b < bucket_count; ++b ) {
+				item.histogram[b] = c.histogram[b].load( std::memory_order_relaxed );
+			}
+		}
+		return result;
+	}
+
+	std::string render_profile::to_text( ) const {
+		auto result = std::string( );
+		for( auto const &item : snapshot( ) ) {
+			result += item.tag.name;
+			result += " @" + std::to_string( item.tag.offset );
+			result += ": calls=" + std::to_string( item.calls );
+			result += " errors=" + std::to_string( item.errors );
+			result += " bytes=" + std::to_string( item.bytes );
+			result += " total_ns=" + std::to_string( item.total_ns );
+			result += " histogram=";
+			for( std::size_t b = 0; b < bucket_count; ++b ) {
+				if( b != 0 ) {
+					result += ',';
+				}
+				result += std::to_string( item.histogram[b] );
+			}
+			result += '\n';
+		}
+		return result;
+	}
+
+	std::string render_profile::to_json( ) const {
+		auto result = std::string( "{\"bucket_limits_ns\":[" );
+		// The last bucket has no limit
+		for( std::size_t b = 0; b + 1 < bucket_count; ++b ) {
+			if( b != 0 ) {
+				result += ',';
+			}
+			result += std::to_string( bucket_limit( b ) );
+		}
+		result += "],\"tags\":[";
+		bool is_first = true;
+		for( auto const &item : snapshot( ) ) {
+			if( not is_first ) {
+				result += ',';
+			}
+			is_first = false;
+			result += "{\"name\":";
+			append_json_string( result, item.tag.name );
+			result += ",\"offset\":" + std::to_string( item.tag.offset );
+			result += ",\"calls\":" + std::to_string( item.calls );
+			result += ",\"errors\":" + std::to_string( item.errors );
+			result += ",\"bytes\":" + std::to_string( item.bytes );
+			result += ",\"total_ns\":" + std::to_string( item.total_ns );
+			result += ",\"histogram\":[";
+			for( std::size_t b = 0; b < bucket_count; ++b ) {
+				if( b != 0 ) {
+					result += ',';
+				}
+				result += std::to_string( item.histogram[b] );
+			}
+			result += "]}";
+		}
+		result += "]}";
+		return result;
+	}
+
+	void render_profile::reset( ) noexcept {
+		for( std::size_t n = 0; n < m_tags.size( ); ++n ) {
+			auto &c = m_counters[n];
+			c.calls.store( 0, std::memory_order_relaxed );
+			c.errors.store( 0, std::memory_order_relaxed );
+			c.bytes.store( 0, std::memory_order_relaxed );
+			c.total_ns.store( 0, std::memory_order_relaxed );
+			for( auto &bucket : c.histogram ) {
+				bucket.store( 0, std::memory_order_relaxed );
+			}
+		}
+	}
+} // namespace daw
@@ -0,0 +1,135 @@
+// The MIT License (MIT)
+//
+// Copyright (c) Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+// Checks that rendering a template whose call tags only pass literal arguments does not allocate
+
+#include "parse_template_test.h"
+
+#include <daw/daw_parse_template.h>
+
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <string_view>
+
+using daw::parse_template_test::check;
+
+namespace {
+	bool g_counting = false;
+	std::size_t g_allocations = 0;
+
+	void *counted_alloc( std::size_t size ) {
+		if( g_counting ) {
+			++g_allocations;
+		}
+		if( auto *ptr = std::malloc( size == 0 ? 1 : size ) ) {
+			return ptr;
+		}
+		throw std::bad_alloc( );
+	}
+
+	/// The number of allocations made while rendering tmp into out
+	template<typename Template, typename... State>
+	std::size_t render_allocations( Template const &tmp, std::string &out, State &...state ) {
+		out.clear( );
+		g_allocations = 0;
+		g_counting = true;
+		tmp.write_to( daw::io::WriteProxy( out ), state... );
+		g_counting = false;
+		return g_allocations;
+	}
+} // namespace
+
+void *operator new( std::size_t size ) {
+	return counted_alloc( size );
+}
+
+void *operator new[]( std::size_t size ) {
+	return counted_alloc( size );
+}
+
+void operator delete( void *ptr ) noexcept {
+	std::free( ptr );
+}
+
+void operator delete[]( void *ptr ) noexcept {
+	std::free( ptr );
+}
+
+void operator delete( void *ptr, std::size_t ) noexcept {
+	std::free( ptr );
+}
+
+void operator delete[]( void *ptr, std::size_t ) noexcept {
+	std::free( ptr );
+}
+
+int main( ) {
+	bool ok = true;
+	auto out = std::string( );
+	out.reserve( 4096 );
+
+	// The escaped strings are longer than any small string buffer, so a copy would allocate
+	auto tmp = daw::parse_template(
+	  "<p><%call args=\"quote,\\\"an escaped\\tstring that is too long to be stored inline\\\"\"%>"
+	  "</p><p><%call args=\"repeat,2,\\\"another string that must not be copied per render\\\"\"%>"
+	  "</p><p><%call args=\"counted,\\\"a third string passed along with the render state\\\"\"%>"
+	  "</p>\n" );
+	tmp.add_callback<daw::escaped_string>(
+	  "quote",
+	  []( std::string_view str, daw::io::WriteProxy &writer ) { (void)writer.write( str ); } );
+	tmp.add_callback<int, daw::escaped_string>(
+	  "repeat",
+	  []( int count, std::string const &str, daw::io::WriteProxy &writer ) {
+		  while( count-- > 0 ) {
+			  (void)writer.write( str );
+		  }
+	  } );
+	tmp.add_stateful_callback<int, daw::escaped_string>(
+	  "counted",
+	  []( std::string_view str, daw::io::WriteProxy &writer, int &renders ) {
+		  ++renders;
+		  (void)writer.write( str );
+	  } );
+	tmp.finalize( );
+
+	auto const expected = std::string(
+	  "<p>an escaped\tstring that is too long to be stored inline</p>"
+	  "<p>another string that must not be copied per renderanother string that must not be copied "
+	  "per render</p><p>a third string passed along with the render state</p>\n" );
+	int renders = 0;
+	ok &= check( render_allocations( tmp, out, renders ) == 0, "Rendering allocated" );
+	ok &= check( out == expected, "Unexpected output" );
+	ok &= check( render_allocations( tmp, out, renders ) == 0, "Rendering again allocated" );
+	ok &= check( renders == 2, "Unexpected state" );
+
+	// Callbacks taking an owning string by value still work, they get a copy
+	auto owning = daw::parse_template( "<%call args=\"own,\\\"value\\\"\"%>" );
+	owning.add_callback<daw::escaped_string>( "own", []( std::string str ) {
+		str += '!';
+		return str;
+	} );
+	ok &= check( owning.to_string( ) == "value!", "Unexpected owning output" );
+
+	return daw::parse_template_test::test_result( "arg_allocation_test", ok );
+}
@@ -0,0 +1,283 @@
+// The MIT License (MIT)
+//
+// Copyright (c) Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+// Checks that async_template suspends at async calls, resumes when they complete in any order,
+// and produces the same output as a synchronous render.  Also that failing callbacks and async
+// calls in blocks are reported
+
+#include "parse_template_test.h"
+
+#include <daw/daw_parse_template_async.h>
+
+#include <coroutine>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using daw::parse_template_test::check;
+using daw::parse_template_test::throws;
+
+namespace {
+	/// A stand in for a slow data source.  Lookups stay suspended until complete_all resumes them,
+	/// last requested first, through the executor
+	class fake_lookup {
+		struct request {
+			std::coroutine_handle<> handle;
+			std::string key;
+			std::string *result;
+		};
+		daw::local_executor *m_executor;
+		std::vector<request> m_requests{ };
+
+	public:
+		explicit fake_lookup( daw::local_executor &executor )
+		  : m_executor( &executor ) {}
+
+		auto lookup( std::string key ) {
+			struct awaiter {
+				fake_lookup &service;
+				std::string key;
+				std::string result{ };
+
+				bool await_ready( ) const noexcept {
+					return false;
+				}
+
+				void await_suspend( std::coroutine_handle<> h ) {
+					service.m_requests.push_back( request{ h, key, &result } );
+				}
+
+				std::string await_resume( ) {
+					return std::move( result );
+				}
+			};
+			return awaiter{ *this, std::move( key ) };
+		}
+
+		[[nodiscard]] std::size_t pending( ) const noexcept {
+			return m_requests.size( );
+		}
+
+		void complete_all( ) {
+			while( not m_requests.empty( ) ) {
+				auto r = std::move( m_requests.back( ) );
+				m_requests.pop_back( );
+				*r.result = "value of " + r.key;
+				m_executor->post( r.handle );
+			}
+		}
+	};
+
+	struct page_state {
+		std::string user;
+		int renders = 0;
+	};
+
+	struct recorded_error {
+		daw::parse_template_error_types type;
+		std::string message;
+	};
+
+	/// Reports errors as a recorded_error, so that tests can check their type
+	struct recording_handler {
+		[[noreturn]] void operator( )( daw::parse_template_error_types type,
+		                               daw::string_view,
+		                               daw::string_view message ) const {
+			throw recorded_error{ type, std::string( message.data( ), message.size( ) ) };
+		}
+	};
+} // namespace
+
+int main( ) {
+	bool ok = true;
+	auto executor = daw::local_executor( );
+	auto service = fake_lookup( executor );
+
+	auto tmp = daw::async_template(
+	  "<h1><%call args=\"title\"%></h1><p><%call args=\"lookup,first\"%></p>"
+	  "<p><%call args=\"user\"%></p><p><%call args=\"count,20\"%></p><%call args=\"renders\"%>\n" );
+	tmp.add_callback( "title", [] { return "Title"; } );
+	tmp.add_async_callback<std::string>( "lookup", [&]( std::string key ) {
+		return service.lookup( std::move( key ) );
+	} );
+	tmp.add_async_stateful_callback<page_state>( "user", [&]( page_state &state ) {
+		return service.lookup( state.user );
+	} );
+	// An async_task callback that yields to the executor before producing a number
+	tmp.add_async_callback<int>( "count", [&]( int n ) -> daw::async_task<int> {
+		co_await executor.schedule( );
+		co_return n * 2;
+	} );
+	tmp.add_stateful_callback<page_state>( "renders",
+	                                       []( page_state &state ) { return ++state.renders; } );
+	tmp.finalize( );
+
+	auto expected = []( std::string const &user ) {
+		return "<h1>Title</h1><p>value of first</p><p>value of " + user + "</p><p>40</p>1\n";
+	};
+
+	// Many renders in flight at once on one thread, completed in reverse order
+	auto states = std::vector<page_state>( );
+	for( int n = 0; n < 1000; ++n ) {
+		states.push_back( page_state{ "user" + std::to_string( n ) } );
+	}
+	auto tasks = std::vector<daw::async_task<std::string>>( );
+	for( auto &state : states ) {
+		tasks.push_back( tmp.render( state ) );
+		tasks.back( ).start( );
+	}
+	ok &= check( service.pending( ) == states.size( ), "Each render should suspend on its lookup" );
+	while( service.pending( ) > 0 or not executor.empty( ) ) {
+		service.complete_all( );
+		executor.run( );
+	}
+	for( std::size_t n = 0; n < tasks.size( ); ++n ) {
+		ok &= check( tasks[n].done( ), "Render did not complete" );
+		if( tasks[n].done( ) ) {
+			ok &= check( tasks[n].get( ) == expected( states[n].user ), "Unexpected render output" );
+		}
+	}
+
+	// sync_wait drives a single render whose callbacks only need the executor
+	auto doubled = daw::async_template( "n=<%call args=\"count,5\"%>\n" );
+	doubled.add_async_callback<int>( "count", [&]( int n ) -> daw::async_task<int> {
+		co_await executor.schedule( );
+		co_return n * 2;
+	} );
+	ok &= check( daw::sync_wait( executor, doubled.render( ) ) == "n=10\n",
+	             "Unexpected sync_wait output" );
+
+	// Exceptions from an async callback are reported through the error handler
+	auto failing = daw::async_template( "a<%call args=\"fail\"%>b" );
+	failing.add_async_callback( "fail", [&]( ) -> daw::async_task<std::string> {
+		co_await executor.schedule( );
+		throw std::runtime_error( "lookup failed" );
+	} );
+	try {
+		(void)daw::sync_wait( executor, failing.render( ) );
+		ok &= check( false, "Expected the callback exception to be reported" );
+	} catch( std::runtime_error const &ex ) {
+		ok &= check( std::string( ex.what( ) ) == "lookup failed", "Unexpected error message" );
+	}
+
+	// The error handler is given callback_exception for an awaitable that fails
+	auto reported =
+	  daw::async_template<recording_handler>( "a<%call args=\"fail\"%>b", recording_handler{ } );
+	reported.add_async_callback( "fail", [&]( ) -> daw::async_task<int> {
+		co_await executor.schedule( );
+		throw std::runtime_error( "no value" );
+	} );
+	try {
+		(void)daw::sync_wait( executor, reported.render( ) );
+		ok &= check( false, "Expected the failing awaitable to be reported" );
+	} catch( recorded_error const &err ) {
+		ok &= check( err.type == daw::parse_template_error_types::callback_exception and
+		               err.message == "no value",
+		             "Expected a callback_exception error" );
+	}
+
+	// Async calls around a cache block, whose synchronous calls are passed the render's state
+	auto mixed = daw::async_template( "<%call args=\"count,2\"%>|<%cache args=\"menu,60\"%>"
+	                                  "[<%call args=\"name\"%>:<%call args=\"renders\"%>]"
+	                                  "<%endcache%>|<%call args=\"count,3\"%>\n" );
+	mixed.add_async_callback<int>( "count", [&]( int n ) -> daw::async_task<int> {
+		co_await executor.schedule( );
+		co_return n * 2;
+	} );
+	mixed.add_stateful_callback<page_state>( "name",
+	                                         []( page_state &state ) { return state.user; } );
+	mixed.add_stateful_callback<page_state>( "renders",
+	                                         []( page_state &state ) { return ++state.renders; } );
+	auto first = page_state{ "ada" };
+	auto second = page_state{ "bob" };
+	ok &= check( daw::sync_wait( executor, mixed.render( first ) ) == "4|[ada:1]|6\n",
+	             "Unexpected output around a cache block" );
+	ok &= check( daw::sync_wait( executor, mixed.render( second ) ) == "4|[ada:1]|6\n" and
+	               second.renders == 0,
+	             "Expected the cached block on the second render" );
+
+	// Arguments outlive the callback's first suspension, so they may be taken by reference, and
+	// synchronous callbacks taking a void * are passed the render's state
+	auto by_ref = daw::async_template(
+	  "<%call args=\"echo,\\\"a long enough string to be allocated\\\"\"%>|<%call args=\"raw\"%>|"
+	  "<%call args=\"direct\"%>\n" );
+	by_ref.add_async_callback<daw::escaped_string>(
+	  "echo",
+	  [&]( std::string_view text ) -> daw::async_task<std::string> {
+		  co_await executor.schedule( );
+		  co_return std::string( text );
+	  } );
+	by_ref.add_callback( "raw", []( void *state ) {
+		return static_cast<page_state *>( state )->user;
+	} );
+	by_ref.add_callback( "direct", []( daw::io::WriteProxy &writer, void *state ) {
+		(void)writer.write( static_cast<page_state *>( state )->user );
+	} );
+	auto ref_state = page_state{ "carol" };
+	ok &= check( daw::sync_wait( executor, by_ref.render( ref_state ) ) ==
+	               "a long enough string to be allocated|carol|carol\n",
+	             "Unexpected output for arguments taken by reference" );
+
+	// The awaited value is escaped as the call tag's escape attribute, or the default escape
+	auto escaped = daw::async_template( "<b><%call escape=\"html\" args=\"quote\"%></b>"
+	                                    "<%call args=\"quote\"%>"
+	                                    "<%call escape=\"none\" args=\"quote\"%>" );
+	escaped.add_async_callback( "quote", [&]( ) -> daw::async_task<std::string> {
+		co_await executor.schedule( );
+		co_return "<\"a\"&'b'>";
+	} );
+	ok &= check( daw::sync_wait( executor, escaped.render( ) ) ==
+	               "<b>&lt;&quot;a&quot;&amp;&#39;b&#39;&gt;</b><\"a\"&'b'><\"a\"&'b'>",
+	             "Unexpected output for an escaped async call" );
+	escaped.set_default_escape( daw::escape_mode::html );
+	ok &= check( daw::sync_wait( executor, escaped.render( ) ) ==
+	               "<b>&lt;&quot;a&quot;&amp;&#39;b&#39;&gt;</b>&lt;&quot;a&quot;&amp;&#39;b&#39;&gt;"
+	               "<\"a\"&'b'>",
+	             "Expected the default escape for an async call without an escape attribute" );
+
+	// Async calls inside a block cannot suspend the render, so adding one is an error
+	auto slow = []( ) -> daw::async_task<std::string> {
+		co_return "slow";
+	};
+	auto cached = daw::async_template( "<%cache args=\"k,60\"%><%call args=\"slow\"%><%endcache%>" );
+	ok &= check( throws( [&] { cached.add_async_callback( "slow", slow ); } ),
+	             "Expected an error for an async call inside a cache block" );
+
+	// Block tags are rejected when the template is compiled, with or without async calls
+	ok &= check( throws( [] { (void)daw::async_template( "<%if args=\"x\"%>x<%endif%>" ); } ),
+	             "Expected an error for an if block" );
+	ok &= check( throws( [] { (void)daw::async_template( "<%each args=\"x\"%>x<%endeach%>" ); } ),
+	             "Expected an error for an each block" );
+	try {
+		(void)daw::async_template<recording_handler>(
+		  "<%call args=\"count,1\"%><%each args=\"rows\"%><%call args=\"count,2\"%><%endeach%>",
+		  recording_handler{ } );
+		ok &= check( false, "Expected an error for an each block with async calls" );
+	} catch( recorded_error const &err ) {
+		ok &= check( err.type == daw::parse_template_error_types::unknown_tag,
+		             "Expected an unknown_tag error for an each block" );
+	}
+
+	return daw::parse_template_test::test_result( "async_template_test", ok );
+}
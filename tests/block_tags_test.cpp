@@ -0,0 +1,119 @@
+// The MIT License (MIT)
+//
+// Copyright (c) Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+// Checks that <%each%> and <%if%> blocks render their parts in place for counts, ranges, and
+// predicates
+
+#include "parse_template_test.h"
+
+#include <daw/daw_parse_template.h>
+
+#include <string>
+#include <vector>
+
+using daw::parse_template_test::check;
+using daw::parse_template_test::throws;
+
+namespace {
+	struct row {
+		std::string name;
+		int quantity;
+		std::vector<std::string> tags;
+	};
+
+	struct page {
+		std::vector<row> rows;
+		bool show_footer;
+	};
+} // namespace
+
+int main( ) {
+	bool ok = true;
+
+	// A count, with the block seeing the outer state
+	auto repeat =
+	  daw::parse_template( "<%each args=\"times,3\"%>[<%call args=\"next\"%>]<%endeach%>\n" );
+	repeat.add_block_callback<int>( "times", []( int n ) { return n; } );
+	repeat.add_stateful_callback<int>( "next", []( int &n ) { return n++; } );
+	int counter = 0;
+	ok &= check( repeat.to_string( counter ) == "[0][1][2]\n", "Unexpected count loop output" );
+
+	// A range from the state, each element is the state of its iteration.  Blocks nest
+	auto table = daw::parse_template(
+	  "<table><%each args=\"rows\"%><tr><td><%call args=\"name\"%></td>"
+	  "<%if args=\"in_stock\"%><td><%call args=\"quantity\"%></td><%else%><td>none</td><%endif%>"
+	  "<td><%each args=\"tags\"%><%call args=\"tag\"%>;<%endeach%></td></tr><%endeach%></table>"
+	  "<%if args=\"footer\"%><footer/><%endif%>\n" );
+	table.add_stateful_block_callback<page>( "rows", []( page &p ) -> std::vector<row> & {
+		return p.rows;
+	} );
+	table.add_stateful_block_callback<row>( "in_stock", []( row &r ) { return r.quantity > 0; } );
+	table.add_stateful_block_callback<row>( "tags", []( row &r ) -> std::vector<std::string> & {
+		return r.tags;
+	} );
+	table.add_stateful_block_callback<page>( "footer", []( page &p ) { return p.show_footer; } );
+	table.add_stateful_callback<row>( "name", []( row &r ) { return r.name; } );
+	table.add_stateful_callback<row>( "quantity", []( row &r ) { return r.quantity; } );
+	table.add_stateful_callback<std::string>( "tag", []( std::string &t ) { return t; } );
+	table.finalize( );
+
+	auto state = page{ { }, true };
+	auto expected = std::string( "<table>" );
+	for( int n = 0; n < 5000; ++n ) {
+		auto r = row{ "item" + std::to_string( n ), n % 3, { } };
+		for( int t = 0; t < n % 4; ++t ) {
+			r.tags.push_back( "t" + std::to_string( t ) );
+		}
+		expected += "<tr><td>" + r.name + "</td><td>" +
+		            ( r.quantity > 0 ? std::to_string( r.quantity ) : std::string( "none" ) ) +
+		            "</td><td>";
+		for( auto const &t : r.tags ) {
+			expected += t + ";";
+		}
+		expected += "</td></tr>";
+		state.rows.push_back( std::move( r ) );
+	}
+	expected += "</table><footer/>\n";
+	ok &= check( table.to_string( state ) == expected, "Unexpected table output" );
+
+	state.rows.clear( );
+	state.show_footer = false;
+	ok &= check( table.to_string( state ) == "<table></table>\n", "Unexpected empty table output" );
+
+	// Mismatched blocks are reported when compiling, and unbound blocks when rendering
+	ok &= check( throws( [] { daw::parse_template( "<%if args=\"a\"%>x" ); } ),
+	             "Missing <%endif%> should be reported" );
+	ok &= check( throws( [] { daw::parse_template( "<%each args=\"a\"%>x<%endif%>" ); } ),
+	             "Mismatched end tag should be reported" );
+	ok &= check( throws( [] { daw::parse_template( "x<%else%>y" ); } ),
+	             "<%else%> outside an <%if%> should be reported" );
+	auto unbound = daw::parse_template( "<%if args=\"flag\"%>x<%endif%>" );
+	unbound.add_callback( "flag", [] { return true; } );
+	ok &= check( throws( [&] { (void)unbound.to_string( ); } ),
+	             "Block callbacks are bound by add_block_callback" );
+	auto wrong_type = daw::parse_template( "<%each args=\"items\"%>x<%endeach%>" );
+	ok &= check( throws( [&] { wrong_type.add_block_callback( "items", [] { return 1.5; } ); } ),
+	             "An each callback must return a count or a range" );
+
+	return daw::parse_template_test::test_result( "block_tags_test", ok );
+}
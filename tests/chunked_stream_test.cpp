@@ -0,0 +1,98 @@
+// The MIT License (MIT)
+//
+// Copyright (c) Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+// Checks that chunked_stream passes the full output to the sink in chunks no larger than the
+// buffer, honours <%flush%>, and ends the render when the sink stops
+
+#include "parse_template_test.h"
+
+#include <daw/daw_parse_template_stream.h>
+
+#include <string>
+#include <vector>
+
+using daw::parse_template_test::check;
+
+int main( ) {
+	auto tmp = daw::parse_template(
+	  "<%call args=\"header\"%>\n<%flush%>body <%call args=\"body\"%>\n<%flush%>footer\n" );
+	tmp.add_callback( "header", [] { return std::string( "header" ); } );
+	int body_calls = 0;
+	tmp.add_callback( "body", [&] {
+		++body_calls;
+		return std::string( 1000, 'x' );
+	} );
+	tmp.finalize( );
+	auto const expected = tmp.to_string( );
+	body_calls = 0;
+
+	bool ok = true;
+
+	// Small buffer: every chunk fits and the concatenation matches to_string
+	auto chunks = std::vector<std::string>( );
+	auto options = daw::chunked_stream_options{ };
+	options.buffer_size = 64;
+	auto stream = daw::chunked_stream(
+	  [&]( daw::string_view chunk ) { chunks.emplace_back( chunk.data( ), chunk.size( ) ); },
+	  options );
+	auto result = stream.render( tmp );
+	auto joined = std::string( );
+	for( auto const &chunk : chunks ) {
+		ok &= check( chunk.size( ) <= 64, "Chunk larger than the buffer" );
+		joined += chunk;
+	}
+	ok &= check( joined == expected, "Chunked output differs from to_string" );
+	ok &= check( result.bytes == expected.size( ), "Unexpected byte count" );
+	ok &= check( result.chunks == chunks.size( ), "Unexpected chunk count" );
+	ok &= check( not result.stopped, "Render unexpectedly stopped" );
+
+	// Large buffer: chunks end exactly at the flush points
+	chunks.clear( );
+	auto large_stream = daw::chunked_stream(
+	  [&]( daw::string_view chunk ) { chunks.emplace_back( chunk.data( ), chunk.size( ) ); } );
+	large_stream.render( tmp );
+	ok &= check( chunks.size( ) == 3, "Expected one chunk per flush point plus the tail" );
+	if( chunks.size( ) == 3 ) {
+		ok &= check( chunks[0] == "header\n", "First chunk should end at the first flush" );
+		ok &= check( chunks[2] == "footer\n", "Last chunk should follow the second flush" );
+	}
+
+	// The buffer is reused for a second render
+	chunks.clear( );
+	large_stream.render( tmp );
+	ok &= check( chunks.size( ) == 3, "Second render should produce the same chunks" );
+
+	// A sink that stops after the first chunk ends the render before the body callback runs
+	body_calls = 0;
+	std::size_t stop_calls = 0;
+	auto stopping_stream = daw::chunked_stream( [&]( daw::string_view ) {
+		++stop_calls;
+		return daw::stream_status::stop;
+	} );
+	result = stopping_stream.render( tmp );
+	ok &= check( result.stopped, "Render should report the stop" );
+	ok &= check( stop_calls == 1, "Sink should not be called after it stops" );
+	ok &= check( body_calls == 0, "Callbacks after a stop should not run" );
+
+	return daw::parse_template_test::test_result( "chunked_stream_test", ok );
+}
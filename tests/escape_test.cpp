@@ -0,0 +1,216 @@
+// The MIT License (MIT)
+//
+// Copyright (c) Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+// Checks the escape filters against a byte at a time reference at every supported instruction
+// set, and that the escape attribute and the template default apply to each kind of callback
+
+#include "parse_template_test.h"
+
+#include <daw/daw_parse_template.h>
+#include <daw/daw_template_includes.h>
+
+#include <cstddef>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+
+using daw::parse_template_test::check;
+using daw::parse_template_test::throws;
+
+namespace {
+	std::string hex( char const *prefix, unsigned char c, char const *suffix ) {
+		char buffer[16];
+		std::snprintf( buffer, sizeof( buffer ), "%s%02X%s", prefix, c, suffix );
+		return buffer;
+	}
+
+	std::string reference_escape( std::string const &str, daw::escape_mode mode ) {
+		auto result = std::string( );
+		for( char ch : str ) {
+			auto const c = static_cast<unsigned char>( ch );
+			switch( mode ) {
+			case daw::escape_mode::none:
+				result += ch;
+				break;
+			case daw::escape_mode::html:
+			case daw::escape_mode::attr:
+				switch( ch ) {
+				case '&':
+					result += "&amp;";
+					break;
+				case '<':
+					result += "&lt;";
+					break;
+				case '>':
+					result += "&gt;";
+					break;
+				case '"':
+					result += "&quot;";
+					break;
+				case '\'':
+					result += "&#39;";
+					break;
+				default:
+					if( mode == daw::escape_mode::attr and ( c <= 0x20U or ch == '`' or ch == '=' ) ) {
+						result += hex( "&#x", c, ";" );
+					} else {
+						result += ch;
+					}
+				}
+				break;
+			case daw::escape_mode::url:
+				if( ( c >= 'a' and c <= 'z' ) or ( c >= 'A' and c <= 'Z' ) or ( c >= '0' and c <= '9' ) or
+				    ch == '-' or ch == '.' or ch == '_' or ch == '~' ) {
+					result += ch;
+				} else {
+					result += hex( "%", c, "" );
+				}
+				break;
+			case daw::escape_mode::json:
+				switch( ch ) {
+				case '"':
+					result += "\\\"";
+					break;
+				case '\\':
+					result += "\\\\";
+					break;
+				case '\b':
+					result += "\\b";
+					break;
+				case '\f':
+					result += "\\f";
+					break;
+				case '\n':
+					result += "\\n";
+					break;
+				case '\r':
+					result += "\\r";
+					break;
+				case '\t':
+					result += "\\t";
+					break;
+				default:
+					if( c < 0x20U ) {
+						result += hex( "\\u00", c, "" );
+					} else {
+						result += ch;
+					}
+				}
+				break;
+			}
+		}
+		return result;
+	}
+
+	std::size_t check_filters( ) {
+		using daw::parse_template_impl::simd_level;
+		auto rng = std::mt19937( 42 );
+		// Mostly clean text, so that escaped characters are found at every offset in a block
+		auto sparse = std::uniform_int_distribution<int>( 0, 30 );
+		auto any_byte = std::uniform_int_distribution<int>( 0, 255 );
+
+		std::size_t failures = 0;
+		for( auto level : { simd_level::scalar, simd_level::sse2, simd_level::avx2 } ) {
+			if( daw::parse_template_impl::set_simd_level( level ) != level ) {
+				continue;
+			}
+			for( auto mode : { daw::escape_mode::html,
+			                   daw::escape_mode::attr,
+			                   daw::escape_mode::url,
+			                   daw::escape_mode::json } ) {
+				for( std::size_t size = 0; size < 100; ++size ) {
+					for( int iteration = 0; iteration < 20; ++iteration ) {
+						auto str = std::string( size, 'x' );
+						for( auto &c : str ) {
+							if( sparse( rng ) == 0 ) {
+								c = static_cast<char>( any_byte( rng ) );
+							}
+						}
+						auto result = std::string( );
+						auto writer = daw::io::WriteProxy( result );
+						(void)daw::parse_template_impl::write_escaped(
+						  writer,
+						  daw::string_view( str.data( ), str.size( ) ),
+						  mode );
+						if( result != reference_escape( str, mode ) ) {
+							std::cerr << "Mismatch at level " << static_cast<int>( level ) << " for mode "
+							          << static_cast<int>( mode ) << '\n';
+							++failures;
+						}
+					}
+				}
+			}
+		}
+		daw::parse_template_impl::set_simd_level( simd_level::avx2 );
+		return failures;
+	}
+} // namespace
+
+int main( ) {
+	bool ok = check( check_filters( ) == 0, "Escape filters differ from the reference" );
+
+	// Each kind of callback output, string, arithmetic, and written to the WriteProxy
+	auto page = daw::parse_template(
+	  "<p title=<%call escape=\"attr\" args=\"title\"%>><%call escape=\"html\" args=\"name\"%></p>"
+	  "<a href=\"/q?<%call escape=\"url\" args=\"query\"%>&n=<%call escape=\"url\" args=\"n\"%>\">"
+	  "<script>var s = \"<%call args=\"echo,\\\"say \\\\\\\"hi\\\\\\\"\\\"\" escape=\"json\"%>\";"
+	  "</script>\n" );
+	page.add_callback( "title", []( daw::io::WriteProxy &writer ) {
+		(void)writer.write( "a=b c" );
+	} );
+	page.add_callback( "name", [] { return std::string( "<b>Tom & 'Jerry'</b>" ); } );
+	page.add_callback( "query", [] { return "a b/c"; } );
+	page.add_callback( "n", [] { return -5; } );
+	page.add_callback<daw::escaped_string>( "echo", []( std::string const &str ) { return str; } );
+	ok &= check( page.to_string( ) ==
+	               "<p title=a&#x3D;b&#x20;c>&lt;b&gt;Tom &amp; &#39;Jerry&#39;&lt;/b&gt;</p>"
+	               "<a href=\"/q?a%20b%2Fc&n=-5\">"
+	               "<script>var s = \"say \\\\\\\"hi\\\\\\\"\";</script>\n",
+	             "Unexpected escaped output" );
+
+	// The template default applies to call tags without an escape attribute
+	auto defaulted = daw::parse_template(
+	  "<%call args=\"name\"%>|<%call escape=\"none\" args=\"name\"%>|<%call args=\"name\"%>\n" );
+	defaulted.add_callback( "name", [] { return "<i>"; } );
+	ok &= check( defaulted.to_string( ) == "<i>|<i>|<i>\n", "Unexpected output without escaping" );
+	defaulted.set_default_escape( daw::escape_mode::html );
+	ok &= check( defaulted.default_escape( ) == daw::escape_mode::html, "Unexpected default" );
+	ok &= check( defaulted.to_string( ) == "&lt;i&gt;|<i>|&lt;i&gt;\n",
+	             "Unexpected output with a default" );
+
+	// Included call tags keep their escape attribute
+	auto includes = daw::template_includes( );
+	includes.add( "user", "<b><%call escape=\"html\" args=\"user\"%></b>" );
+	auto with_include = includes.compile( "<%include args=\"user\"%>\n" );
+	with_include.add_callback( "user", [] { return "<alice>"; } );
+	ok &= check( with_include.to_string( ) == "<b>&lt;alice&gt;</b>\n",
+	             "Unexpected output of an included tag" );
+
+	ok &= check( throws( [] { (void)daw::parse_template( "<%call escape=\"xml\" args=\"x\"%>" ); } ),
+	             "Expected an error for an unknown escape" );
+	ok &= check( throws( [] { (void)daw::parse_template( "<%call escape=\"html args=\"x\"%>" ); } ),
+	             "Expected an error for an unterminated escape" );
+
+	return daw::parse_template_test::test_result( "escape_test", ok );
+}
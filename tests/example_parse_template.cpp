@@ -84,15 +84,19 @@ int main( int argc, char const **argv ) {
 		  return result;
 	  } );
 
-	int x = 1;
-	p.add_stateful_callback<int>( "stateful_test", [count = 0]( int &v ) mutable {
-		count += v;
-		return count;
+	struct render_state {
+		int step;
+		int count;
+	};
+	auto state = render_state{ 1, 0 };
+	p.add_stateful_callback<render_state>( "stateful_test", []( render_state &s ) {
+		s.count += s.step;
+		return s.count;
 	} );
 
-	p.write_to( std::cout, x );
-	x = -x;
-	p.write_to( std::cout, x );
+	p.write_to( std::cout, state );
+	state.step = -state.step;
+	p.write_to( std::cout, state );
 
 	return EXIT_SUCCESS;
 }
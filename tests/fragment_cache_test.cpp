@@ -0,0 +1,144 @@
+// The MIT License (MIT)
+//
+// Copyright (c) Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+// Checks that <%cache%> blocks replay cached output, expire, evict, and count hits and misses
+
+#include "parse_template_test.h"
+
+#include <daw/daw_fragment_cache.h>
+#include <daw/daw_parse_template.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using daw::parse_template_test::check;
+using daw::parse_template_test::throws;
+
+int main( ) {
+	bool ok = true;
+
+	// Enclosed parts only run on a miss
+	std::atomic<int> menu_calls{ 0 };
+	auto tmp = daw::parse_template(
+	  "<nav><%cache args=\"menu\"%><ul><%call args=\"menu\"%></ul><%endcache%></nav>"
+	  "<p><%call args=\"count\"%></p>\n" );
+	tmp.add_callback( "menu", [&] {
+		++menu_calls;
+		return std::string( "<li>Home</li>" );
+	} );
+	int count = 0;
+	tmp.add_stateful_callback<int>( "count", []( int &n ) { return ++n; } );
+	ok &= check( tmp.get_fragment_cache( ) != nullptr, "A template with cache blocks has a cache" );
+	for( int n = 1; n <= 3; ++n ) {
+		auto const expected = "<nav><ul><li>Home</li></ul></nav><p>" + std::to_string( n ) + "</p>\n";
+		ok &= check( tmp.to_string( count ) == expected, "Unexpected output" );
+	}
+	ok &= check( menu_calls == 1, "The cached block should only be rendered once" );
+	auto stats = tmp.get_fragment_cache( )->stats( );
+	ok &= check( stats.hits == 2 and stats.misses == 1, "Unexpected hit/miss counts" );
+	ok &= check( stats.entries == 1, "Unexpected entry count" );
+
+	// Concurrent renders all see the same output
+	auto threads = std::vector<std::thread>( );
+	std::atomic<int> mismatches{ 0 };
+	for( int t = 0; t < 4; ++t ) {
+		threads.emplace_back( [&] {
+			int local = 0;
+			for( int n = 0; n < 1000; ++n ) {
+				if( tmp.to_string( local ).find( "<li>Home</li>" ) == std::string::npos ) {
+					++mismatches;
+				}
+			}
+		} );
+	}
+	for( auto &th : threads ) {
+		th.join( );
+	}
+	ok &= check( mismatches == 0, "Concurrent render missing the cached block" );
+	stats = tmp.get_fragment_cache( )->stats( );
+	ok &= check( stats.hits + stats.misses == 4003, "Every render should count a hit or miss" );
+
+	// Entries expire after their ttl
+	int ttl_calls = 0;
+	auto expiring =
+	  daw::parse_template( "<%cache args=\"clock,1\"%><%call args=\"tick\"%><%endcache%>\n" );
+	expiring.add_callback( "tick", [&] { return ++ttl_calls; } );
+	ok &= check( expiring.to_string( ) == "1\n", "Unexpected first render" );
+	ok &= check( expiring.to_string( ) == "1\n", "Render within the ttl should be cached" );
+	std::this_thread::sleep_for( std::chrono::milliseconds( 1100 ) );
+	ok &= check( expiring.to_string( ) == "2\n", "Render after the ttl should run the block" );
+
+	// A small shared cache evicts and stays within its bound.  The key is the block's key, so
+	// templates sharing a cache share entries
+	auto shared = std::make_shared<daw::fragment_cache>( 16 * 64 );
+	auto first = daw::parse_template( "<%cache args=\"shared\"%>first<%endcache%>" );
+	auto second = daw::parse_template( "<%cache args=\"shared\"%>second<%endcache%>" );
+	first.set_fragment_cache( shared );
+	second.set_fragment_cache( shared );
+	ok &= check( first.to_string( ) == "first", "Unexpected shared first render" );
+	ok &= check( second.to_string( ) == "first", "Shared keys should share entries" );
+	for( int n = 0; n < 1000; ++n ) {
+		auto key = "key" + std::to_string( n );
+		shared->insert( key, std::string( 20, 'x' ), std::chrono::seconds( 0 ) );
+	}
+	stats = shared->stats( );
+	ok &= check( stats.evictions > 0, "Expected evictions" );
+	ok &= check( stats.bytes <= shared->max_bytes( ), "Cache exceeded its bound" );
+
+	// Nested blocks and malformed blocks
+	auto nested = daw::parse_template(
+	  "<%cache args=\"outer\"%>a<%cache args=\"inner\"%>b<%endcache%>c<%endcache%>d" );
+	ok &= check( nested.to_string( ) == "abcd" and nested.to_string( ) == "abcd",
+	             "Unexpected nested output" );
+	bool threw = false;
+	try {
+		auto unterminated = daw::parse_template( "<%cache args=\"open\"%>text" );
+	} catch( std::runtime_error const & ) { threw = true; }
+	ok &= check( threw, "A cache block without <%endcache%> should be an error" );
+	threw = false;
+	try {
+		auto unmatched = daw::parse_template( "text<%endcache%>text" );
+	} catch( std::runtime_error const & ) { threw = true; }
+	ok &= check( threw, "An <%endcache%> without a block should be an error" );
+
+	// The key cannot vary by item, so a cache block inside an each block is an error, and so is
+	// an empty ttl
+	ok &= check( throws( [] {
+		             (void)daw::parse_template(
+		               "<%each args=\"rows\"%><%cache args=\"row\"%>x<%endcache%><%endeach%>" );
+	             } ),
+	             "A cache block inside an each block should be an error" );
+	auto around = daw::parse_template(
+	  "<%cache args=\"rows\"%><%each args=\"rows\"%>x<%endeach%><%endcache%>" );
+	around.add_block_callback( "rows", [] { return 2; } );
+	ok &= check( around.to_string( ) == "xx", "An each block inside a cache block is allowed" );
+	ok &= check( throws( [] { (void)daw::parse_template( "<%cache args=\"k,\"%>x<%endcache%>" ); } ),
+	             "An empty cache ttl should be an error" );
+
+	return daw::parse_template_test::test_result( "fragment_cache_test", ok );
+}
@@ -0,0 +1,118 @@
+// The MIT License (MIT)
+//
+// Copyright (c) Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+// Measures the per item cost of rendering one template for many states with render_batch, compared
+// to calling to_string for each state
+
+#include "parse_template_bench.h"
+
+#include <daw/daw_parse_template.h>
+
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+	struct recipient {
+		std::string name;
+		std::string email;
+		int balance;
+	};
+
+	constexpr char const email_template[] =
+	  "To: <%call args=\"email\"%>\n"
+	  "Subject: Your monthly statement\n\n"
+	  "Dear <%call args=\"name\"%>,\n\n"
+	  "Your balance this month is $<%call args=\"balance\"%>. Thank you for being a customer. If "
+	  "you have any questions about your statement please reply to this email and a member of our "
+	  "team will be in touch.\n\n"
+	  "Regards,\nThe Accounts Team\n";
+} // namespace
+
+int main( ) {
+	constexpr std::size_t item_count = 100'000;
+	auto tmp = daw::parse_template( email_template );
+	tmp.add_stateful_callback<recipient>( "email", []( recipient &r ) { return r.email; } );
+	tmp.add_stateful_callback<recipient>( "name", []( recipient &r ) { return r.name; } );
+	tmp.add_stateful_callback<recipient>( "balance", []( recipient &r ) { return r.balance; } );
+	tmp.finalize( );
+
+	auto states = std::vector<recipient>( );
+	states.reserve( item_count );
+	for( std::size_t n = 0; n < item_count; ++n ) {
+		auto const id = std::to_string( n );
+		states.push_back( recipient{
+		  "Customer " + id, "customer" + id + "@example.com", static_cast<int>( n % 9973 ) } );
+	}
+
+	auto output = daw::render_batch_output( );
+	tmp.render_batch( states, output );
+	auto const total_bytes = output.buffer.size( );
+	for( std::size_t n = 0; n < item_count; n += 997 ) {
+		auto const expected = tmp.to_string( states[n] );
+		if( output[n] != daw::string_view( expected.data( ), expected.size( ) ) ) {
+			std::cerr << "render_batch output differs from to_string for item " << n << '\n';
+			return EXIT_FAILURE;
+		}
+	}
+	std::cout << item_count << " items, " << total_bytes << " bytes per batch\n";
+
+	constexpr std::size_t runs = 20;
+	auto const per_item = [&]( daw::parse_template_bench::bench_result const &result ) {
+		std::cout << "    " << ( result.ns_per_run / static_cast<double>( item_count ) )
+		          << " ns/item\n";
+	};
+
+	auto strings = std::vector<std::string>( );
+	strings.reserve( item_count );
+	per_item( daw::parse_template_bench::bench( "loop of to_string", total_bytes, runs, [&] {
+		strings.clear( );
+		for( auto &state : states ) {
+			strings.push_back( tmp.to_string( state ) );
+		}
+		daw::parse_template_bench::do_not_optimize( strings );
+	} ) );
+
+	per_item( daw::parse_template_bench::bench( "render_batch, new output", total_bytes, runs, [&] {
+		auto result = daw::render_batch_output( );
+		tmp.render_batch( states, result );
+		daw::parse_template_bench::do_not_optimize( result );
+	} ) );
+
+	per_item(
+	  daw::parse_template_bench::bench( "render_batch, reused output", total_bytes, runs, [&] {
+		  tmp.render_batch( states, output );
+		  daw::parse_template_bench::do_not_optimize( output );
+	  } ) );
+
+	per_item( daw::parse_template_bench::bench( "render_batch, sink", total_bytes, runs, [&] {
+		std::size_t bytes = 0;
+		tmp.render_batch( states.begin( ), states.end( ), [&]( std::size_t, daw::string_view item ) {
+			bytes += item.size( );
+		} );
+		daw::parse_template_bench::do_not_optimize( bytes );
+	} ) );
+	return EXIT_SUCCESS;
+}
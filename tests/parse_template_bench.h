@@ -0,0 +1,66 @@
+// The MIT License (MIT)
+//
+// Copyright (c) Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <string_view>
+
+namespace daw::parse_template_bench {
+	template<typename T>
+	inline void do_not_optimize( T const &value ) {
+#if defined( __GNUC__ ) or defined( __clang__ )
+		asm volatile( "" : : "r,m"( value ) : "memory" );
+#else
+		static_cast<void>( *static_cast<T const volatile *>( &value ) );
+#endif
+	}
+
+	struct bench_result {
+		double ns_per_run;
+		double mb_per_sec;
+	};
+
+	/// Run func runs times after a warmup run and print the average time per run and the
+	/// throughput based on bytes processed per run
+	template<typename Func>
+	bench_result bench( std::string_view title, std::size_t bytes, std::size_t runs, Func &&func ) {
+		func( );
+		auto const start = std::chrono::steady_clock::now( );
+		for( std::size_t n = 0; n < runs; ++n ) {
+			func( );
+		}
+		auto const finish = std::chrono::steady_clock::now( );
+		auto const total_ns = static_cast<double>(
+		  std::chrono::duration_cast<std::chrono::nanoseconds>( finish - start ).count( ) );
+		auto const ns_per_run = total_ns / static_cast<double>( runs );
+		auto const mb_per_sec =
+		  ( static_cast<double>( bytes ) / ( 1024.0 * 1024.0 ) ) / ( ns_per_run / 1e9 );
+		std::cout << std::left << std::setw( 40 ) << title << std::right << std::fixed
+		          << std::setprecision( 1 ) << std::setw( 14 ) << ns_per_run << " ns/run"
+		          << std::setw( 12 ) << mb_per_sec << " MB/s\n";
+		return bench_result{ ns_per_run, mb_per_sec };
+	}
+} // namespace daw::parse_template_bench
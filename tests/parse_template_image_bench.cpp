@@ -0,0 +1,101 @@
+// The MIT License (MIT)
+//
+// Copyright (c) Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+// Measures the cold start of many templates, compiling each from its text compared to loading
+// each from its image
+
+#include "parse_template_bench.h"
+
+#include <daw/daw_parse_template.h>
+
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+	/// A page template of a few kilobytes, varied by n so that each is distinct
+	std::string make_template( std::size_t n ) {
+		auto const id = std::to_string( n );
+		auto result = std::string( "<html><head><title>Page " + id + "</title></head><body>\n" );
+		for( std::size_t row = 0; row < 20; ++row ) {
+			result += "<div class=\"row-" + std::to_string( row ) +
+			          "\">Some literal text that would be in a real template, repeated so that the "
+			          "parser has text to scan <%call args=\"value," +
+			          std::to_string( row ) + "\"%> <%call escape=\"html\" args=\"name\"%></div>\n";
+			if( row % 5 == 0 ) {
+				result += "<%if args=\"show\"%><p>Updated <%timestamp args=\"%Y-%m-%d,Etc/UTC\"%></p>"
+				          "<%endif%>\n";
+			}
+		}
+		result += "<%cache args=\"footer-" + id +
+		          ",60\"%><footer>(c)</footer><%endcache%></body></html>\n";
+		return result;
+	}
+} // namespace
+
+int main( ) {
+	constexpr std::size_t template_count = 2'000;
+	auto sources = std::vector<std::string>( );
+	auto images = std::vector<std::string>( );
+	sources.reserve( template_count );
+	images.reserve( template_count );
+	std::size_t source_bytes = 0;
+	std::size_t image_bytes = 0;
+	for( std::size_t n = 0; n < template_count; ++n ) {
+		sources.push_back( make_template( n ) );
+		source_bytes += sources.back( ).size( );
+		images.push_back( daw::parse_template( sources.back( ) ).to_image( ) );
+		image_bytes += images.back( ).size( );
+	}
+	for( std::size_t n = 0; n < template_count; n += 97 ) {
+		if( daw::parse_template( daw::template_image, images[n] ).to_image( ) != images[n] ) {
+			std::cerr << "Loaded template " << n << " differs from the compiled one\n";
+			return EXIT_FAILURE;
+		}
+	}
+	std::cout << template_count << " templates, " << source_bytes << " bytes of source, "
+	          << image_bytes << " bytes of images\n";
+
+	constexpr std::size_t runs = 5;
+	auto const per_template = [&]( daw::parse_template_bench::bench_result const &result ) {
+		std::cout << "    " << ( result.ns_per_run / static_cast<double>( template_count ) )
+		          << " ns/template\n";
+	};
+	per_template( daw::parse_template_bench::bench( "compile all", source_bytes, runs, [&] {
+		std::size_t parts = 0;
+		for( auto const &source : sources ) {
+			parts += daw::parse_template( source ).size_estimate( );
+		}
+		daw::parse_template_bench::do_not_optimize( parts );
+	} ) );
+	per_template( daw::parse_template_bench::bench( "load all from images", image_bytes, runs, [&] {
+		std::size_t parts = 0;
+		for( auto const &image : images ) {
+			parts += daw::parse_template( daw::template_image, image ).size_estimate( );
+		}
+		daw::parse_template_bench::do_not_optimize( parts );
+	} ) );
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,88 @@
+// The MIT License (MIT)
+//
+// Copyright (c) Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+// Measures the cost of profile_to against write_to for a template made of call tags.  write_to does
+// not instantiate any of the profiling code, so its time is that of an uninstrumented render
+
+#include "parse_template_bench.h"
+
+#include <daw/daw_parse_template.h>
+#include <daw/daw_render_profile.h>
+
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace {
+	constexpr std::size_t row_count = 1000;
+
+	std::string make_template( ) {
+		auto result = std::string( "<table>\n" );
+		for( std::size_t n = 0; n < row_count; ++n ) {
+			auto const row = std::to_string( n );
+			result += "<tr><td>Row " + row + "</td><td><%call args=\"cell," + row + "\"%></td></tr>\n";
+		}
+		result += "</table>\n";
+		return result;
+	}
+} // namespace
+
+int main( ) {
+	auto tmp = daw::parse_template( make_template( ) );
+	tmp.add_callback<int>( "cell", []( int value ) { return value * 2; } );
+	tmp.finalize( );
+
+	auto const expected = tmp.to_string( );
+	auto profile = tmp.make_profile( );
+	auto out = std::string( );
+	out.reserve( expected.size( ) );
+	auto writer = daw::io::WriteProxy( out );
+	tmp.profile_to( writer, profile );
+	if( out != expected ) {
+		std::cerr << "Output mismatch between write_to and profile_to\n";
+		return EXIT_FAILURE;
+	}
+	std::cout << "Call tags: " << row_count << ", output size: " << expected.size( ) << " bytes\n";
+
+	constexpr std::size_t runs = 2000;
+	auto const plain = daw::parse_template_bench::bench( "write_to", expected.size( ), runs, [&] {
+		out.clear( );
+		tmp.write_to( writer );
+		daw::parse_template_bench::do_not_optimize( out );
+	} );
+	auto const profiled =
+	  daw::parse_template_bench::bench( "profile_to", expected.size( ), runs, [&] {
+		  out.clear( );
+		  tmp.profile_to( writer, profile );
+		  daw::parse_template_bench::do_not_optimize( out );
+	  } );
+	std::cout << "profiling overhead: "
+	          << ( profiled.ns_per_run - plain.ns_per_run ) / static_cast<double>( row_count )
+	          << " ns/call\n";
+	auto const snapshot = profile.snapshot( );
+	std::cout << "first tag: " << snapshot.front( ).tag.name << " @" << snapshot.front( ).tag.offset
+	          << " calls=" << snapshot.front( ).calls << " total_ns=" << snapshot.front( ).total_ns
+	          << '\n';
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,151 @@
+// The MIT License (MIT)
+//
+// Copyright (c) Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Compares rendering the compiled instruction program against the previous representation, a
+// vector of std::function doc parts where each call tag looked up its callback in a std::map and
+// parsed its arguments on every render
+
+#include "parse_template_bench.h"
+
+#include <daw/daw_parse_template.h>
+#include <daw/io/daw_write_proxy.h>
+
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+	constexpr std::size_t row_count = 1000;
+
+	/// Call parts refer to the template through this, so it is built in place and never moved
+	struct legacy_template {
+		std::vector<std::function<void( daw::io::WriteProxy &, void * )>> parts{ };
+		std::map<std::string, std::function<void( daw::string_view, daw::io::WriteProxy &, void * )>,
+		         std::less<>>
+		  callbacks{ };
+
+		legacy_template( ) = default;
+		legacy_template( legacy_template const & ) = delete;
+		legacy_template( legacy_template && ) = delete;
+		legacy_template &operator=( legacy_template const & ) = delete;
+		legacy_template &operator=( legacy_template && ) = delete;
+
+		template<typename Func>
+		void add_part( Func func ) {
+			// doc_parts wrapped the part function in a second lambda
+			parts.emplace_back( [func = std::move( func )]( daw::io::WriteProxy &writer, void *state ) {
+				func( writer, state );
+			} );
+		}
+
+		void add_text( daw::string_view str ) {
+			add_part( [str]( daw::io::WriteProxy &writer, void * ) { (void)writer.write( str ); } );
+		}
+
+		void add_call( daw::string_view name, daw::string_view args ) {
+			add_part( [this, name, args]( daw::io::WriteProxy &writer, void *state ) {
+				auto &cb = callbacks.find( name )->second;
+				if( not cb ) {
+					std::abort( );
+				}
+				cb( args, writer, state );
+			} );
+		}
+
+		void write_to( daw::io::WriteProxy &writer ) {
+			for( auto const &part : parts ) {
+				part( writer, nullptr );
+			}
+		}
+	};
+
+	std::string make_template( ) {
+		auto result = std::string( "<table>\n" );
+		for( std::size_t n = 0; n < row_count; ++n ) {
+			auto const row = std::to_string( n );
+			result += "<tr><td>Row " + row + "</td><td><%call args=\"cell," + row + "\"%></td></tr>\n";
+		}
+		result += "</table>\n";
+		return result;
+	}
+
+	// Builds the parts the same way the previous process_template did, the template only has call
+	// tags
+	void build_legacy_template( legacy_template &result, daw::string_view template_str ) {
+		result.add_text( template_str.pop_front_until( "<%" ) );
+		while( not template_str.empty( ) ) {
+			auto tag = template_str.pop_front_until( "%>" );
+			tag.remove_prefix_until( "args=\"" );
+			tag = tag.pop_front_until( '"' );
+			auto name = tag.pop_front_until( ',' );
+			result.add_call( name, tag );
+			result.add_text( template_str.pop_front_until( "<%" ) );
+		}
+		result.callbacks["cell"] = []( daw::string_view args, daw::io::WriteProxy &writer, void * ) {
+			using daw::parser::converters::parse_to_value;
+			auto const value = parse_to_value( args, daw::tag<int> );
+			(void)writer.write( std::to_string( value * 2 ) );
+		};
+	}
+} // namespace
+
+int main( ) {
+	auto const template_str = make_template( );
+	auto compiled = daw::parse_template( template_str );
+	compiled.add_callback<int>( "cell", []( int value ) { return value * 2; } );
+	compiled.finalize( );
+
+	auto legacy = legacy_template( );
+	build_legacy_template( legacy, template_str );
+
+	auto expected = compiled.to_string( );
+	auto legacy_out = std::string( );
+	{
+		auto writer = daw::io::WriteProxy( legacy_out );
+		legacy.write_to( writer );
+	}
+	if( expected != legacy_out ) {
+		std::cerr << "Output mismatch between compiled and legacy renders\n";
+		return EXIT_FAILURE;
+	}
+	std::cout << "Template parts: " << ( row_count * 2 + 1 ) << ", output size: " << expected.size( )
+	          << " bytes\n";
+
+	constexpr std::size_t runs = 2000;
+	auto out = std::string( );
+	out.reserve( expected.size( ) );
+	daw::parse_template_bench::bench( "legacy doc_parts write_to", expected.size( ), runs, [&] {
+		out.clear( );
+		auto writer = daw::io::WriteProxy( out );
+		legacy.write_to( writer );
+		daw::parse_template_bench::do_not_optimize( out );
+	} );
+	daw::parse_template_bench::bench( "compiled program write_to", expected.size( ), runs, [&] {
+		out.clear( );
+		compiled.write_to( out );
+		daw::parse_template_bench::do_not_optimize( out );
+	} );
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,219 @@
+// The MIT License (MIT)
+//
+// Copyright (c) Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+// Measures template compile throughput on a multi-megabyte template, comparing the byte at a time
+// delimiter scanning that process_template, find_quote, and find_split_args used to do with the
+// vectorised scanners at each supported instruction set
+
+#include "parse_template_bench.h"
+
+#include <daw/daw_parse_template.h>
+#include <daw/daw_parse_template_scan.h>
+
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+	/// Generate a template of about target_size bytes with paragraphs_per_tag paragraphs of text
+	/// between each pair of tags
+	std::string make_template( std::size_t target_size, std::size_t paragraphs_per_tag ) {
+		auto paragraph = std::string( );
+		for( std::size_t n = 0; n < paragraphs_per_tag; ++n ) {
+			paragraph +=
+			  "<p>Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor "
+			  "incididunt ut labore et dolore magna aliqua. Ut enim ad minim veniam, quis nostrud "
+			  "exercitation ullamco laboris nisi ut aliquip ex ea commodo consequat.</p>\n";
+		}
+		auto result = std::string( );
+		result.reserve( target_size + 1024 );
+		std::size_t n = 0;
+		while( result.size( ) < target_size ) {
+			result += paragraph;
+			result += "<div><%call args=\"row,\\\"item, ";
+			result += std::to_string( n );
+			result += "\\\",";
+			result += std::to_string( n * 7 );
+			result += "\"%></div><span><%date%></span>\n";
+			++n;
+		}
+		return result;
+	}
+
+	// The scanning the compiler did before it was vectorised
+	std::size_t legacy_find_quote( daw::string_view str ) noexcept {
+		bool in_slash = false;
+		for( std::size_t n = 0; n < str.size( ); ++n ) {
+			if( str[n] == '\\' ) {
+				in_slash = true;
+				continue;
+			}
+			if( str[n] == '"' and not in_slash ) {
+				return n;
+			}
+			in_slash = false;
+		}
+		return daw::string_view::npos;
+	}
+
+	std::size_t legacy_split_args( daw::string_view tag ) {
+		std::size_t count = 0;
+		bool in_quote = false;
+		std::size_t last_pos = 0;
+		for( std::size_t n = 0; n < tag.size( ); ++n ) {
+			switch( tag[n] ) {
+			case '"':
+				in_quote = not in_quote;
+				continue;
+			case ',':
+				if( not in_quote ) {
+					++count;
+					last_pos = n + 1;
+				}
+				continue;
+			}
+		}
+		return last_pos < tag.size( ) ? count + 1 : count;
+	}
+
+	std::size_t legacy_scan( daw::string_view str ) {
+		std::size_t count = str.pop_front_until( "<%" ).size( );
+		while( not str.empty( ) ) {
+			auto tag = str.pop_front_until( "%>" );
+			tag.remove_prefix_until( R"(args=")" );
+			if( not tag.empty( ) ) {
+				tag.resize( legacy_find_quote( tag ) );
+				count += legacy_split_args( tag );
+			}
+			count += str.pop_front_until( "<%" ).size( );
+		}
+		return count;
+	}
+
+	std::size_t simd_split_args( daw::string_view tag ) {
+		using daw::parse_template_impl::find_first_of;
+		std::size_t count = 0;
+		bool in_quote = false;
+		std::size_t last_pos = 0;
+		for( std::size_t n = find_first_of( tag, '"', '\\', ',' ); n != daw::string_view::npos;
+		     n = find_first_of( tag, n + 1, '"', '\\', ',' ) ) {
+			switch( tag[n] ) {
+			case '"':
+				in_quote = not in_quote;
+				continue;
+			case ',':
+				if( not in_quote ) {
+					++count;
+					last_pos = n + 1;
+				}
+				continue;
+			}
+		}
+		return last_pos < tag.size( ) ? count + 1 : count;
+	}
+
+	std::size_t simd_scan( daw::string_view str ) {
+		using daw::parse_template_impl::pop_front_until_pair;
+		std::size_t count = pop_front_until_pair( str, '<', '%' ).size( );
+		while( not str.empty( ) ) {
+			auto tag = pop_front_until_pair( str, '%', '>' );
+			tag.remove_prefix_until( R"(args=")" );
+			if( not tag.empty( ) ) {
+				tag.resize( daw::parse_template_impl::find_quote( tag ) );
+				count += simd_split_args( tag );
+			}
+			count += pop_front_until_pair( str, '<', '%' ).size( );
+		}
+		return count;
+	}
+
+	char const *level_name( daw::parse_template_impl::simd_level level ) {
+		switch( level ) {
+		case daw::parse_template_impl::simd_level::avx2:
+			return "avx2";
+		case daw::parse_template_impl::simd_level::sse2:
+			return "sse2";
+		default:
+			return "scalar";
+		}
+	}
+
+	void print_gb_per_sec( daw::parse_template_bench::bench_result const &result ) {
+		std::cout << "    " << ( result.mb_per_sec / 1024.0 ) << " GB/s\n";
+	}
+
+	int run_benchmarks( std::string const &template_str ) {
+		using daw::parse_template_impl::simd_level;
+		std::cout << "\nTemplate size: " << template_str.size( ) << " bytes\n";
+
+		constexpr std::size_t runs = 20;
+		auto const expected = legacy_scan( template_str );
+		print_gb_per_sec(
+		  daw::parse_template_bench::bench( "legacy scan", template_str.size( ), runs, [&] {
+			  daw::parse_template_bench::do_not_optimize( legacy_scan( template_str ) );
+		  } ) );
+
+		auto const levels = { simd_level::scalar, simd_level::sse2, simd_level::avx2 };
+		for( auto level : levels ) {
+			if( daw::parse_template_impl::set_simd_level( level ) != level ) {
+				continue;
+			}
+			if( simd_scan( template_str ) != expected ) {
+				std::cerr << "Scan mismatch using " << level_name( level ) << '\n';
+				return EXIT_FAILURE;
+			}
+			auto const title = std::string( "scan " ) + level_name( level );
+			print_gb_per_sec( daw::parse_template_bench::bench( title, template_str.size( ), runs, [&] {
+				daw::parse_template_bench::do_not_optimize( simd_scan( template_str ) );
+			} ) );
+		}
+
+		for( auto level : levels ) {
+			if( daw::parse_template_impl::set_simd_level( level ) != level ) {
+				continue;
+			}
+			auto const title = std::string( "parse_template construct " ) + level_name( level );
+			print_gb_per_sec( daw::parse_template_bench::bench( title, template_str.size( ), runs, [&] {
+				auto const tmp = daw::parse_template( template_str );
+				daw::parse_template_bench::do_not_optimize( tmp.static_size( ) );
+			} ) );
+		}
+		daw::parse_template_impl::set_simd_level( daw::parse_template_impl::supported_simd_level( ) );
+		return EXIT_SUCCESS;
+	}
+} // namespace
+
+int main( ) {
+	std::cout << "Supported: " << level_name( daw::parse_template_impl::supported_simd_level( ) )
+	          << '\n';
+	// Tag heavy markup, and mostly literal text
+	for( std::size_t paragraphs_per_tag : { 1U, 16U } ) {
+		auto const template_str = make_template( 8U * 1024U * 1024U, paragraphs_per_tag );
+		if( run_benchmarks( template_str ) != EXIT_SUCCESS ) {
+			return EXIT_FAILURE;
+		}
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,309 @@
+// The MIT License (MIT)
+//
+// Copyright (c) Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+// Benchmarks compiling and rendering synthetic templates of varying size, tag density, and argument
+// count.  A line per benchmark is printed to std::clog and the results are written as JSON to the
+// file named by the first argument, or to std::cout when there is none.  bytes is the size of the
+// template for compile results and of the output for render results
+
+#include "parse_template_bench.h"
+
+#include <daw/daw_parse_template.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if not defined( DAW_PARSE_TEMPLATE_VERSION )
+#define DAW_PARSE_TEMPLATE_VERSION "unknown"
+#endif
+
+namespace {
+	enum class tag_mix { none, calls, times, escaped };
+
+	constexpr std::string_view to_string( tag_mix mix ) {
+		switch( mix ) {
+		case tag_mix::none:
+			return "none";
+		case tag_mix::calls:
+			return "calls";
+		case tag_mix::times:
+			return "times";
+		case tag_mix::escaped:
+			return "escaped";
+		}
+		return "unknown";
+	}
+
+	/// The shape of a generated template.  bytes is the approximate size of its literal text and
+	/// tags_per_kb how many tags are placed in each 1024 bytes of it.  Call tags pass arg_count
+	/// integer arguments
+	struct template_shape {
+		std::size_t bytes;
+		std::size_t tags_per_kb;
+		std::size_t arg_count;
+		tag_mix mix;
+	};
+
+	std::string make_tag( template_shape const &shape, std::size_t n ) {
+		switch( shape.mix ) {
+		case tag_mix::none:
+			return { };
+		case tag_mix::calls: {
+			auto result = std::string( "<%call args=\"cell" );
+			for( std::size_t a = 0; a < shape.arg_count; ++a ) {
+				result += ',' + std::to_string( ( n + a ) % 1000 );
+			}
+			return result + "\"%>";
+		}
+		case tag_mix::times:
+			switch( n % 3 ) {
+			case 0:
+				return "<%date%>";
+			case 1:
+				return "<%time%>";
+			default:
+				return "<%timestamp args=\"%Y-%m-%dT%H:%M:%S\"%>";
+			}
+		case tag_mix::escaped:
+			return "<%call args=\"quote,\\\"an escaped\\tvalue and \\\\\\\\ slash\\\"\"%>";
+		}
+		return { };
+	}
+
+	/// Generate a template of HTML like text with tags spread evenly through it
+	std::string generate( template_shape const &shape ) {
+		static constexpr std::string_view filler =
+		  "<p class=\"body\">Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod "
+		  "tempor incididunt ut labore et dolore magna aliqua.</p>\n";
+		auto const has_tags = shape.mix != tag_mix::none and shape.tags_per_kb != 0;
+		auto const text_per_tag =
+		  has_tags ? std::max<std::size_t>( 1024 / shape.tags_per_kb, 1 ) : shape.bytes;
+		auto result = std::string( );
+		std::size_t text_bytes = 0;
+		std::size_t tag_count = 0;
+		while( text_bytes < shape.bytes ) {
+			// The literal text up to the next tag
+			auto run = std::min( text_per_tag, shape.bytes - text_bytes );
+			while( run > 0 ) {
+				auto const pos = text_bytes % filler.size( );
+				auto const size = std::min( run, filler.size( ) - pos );
+				result.append( filler.data( ) + pos, size );
+				text_bytes += size;
+				run -= size;
+			}
+			if( has_tags ) {
+				result += make_tag( shape, tag_count++ );
+			}
+		}
+		return result;
+	}
+
+	template<std::size_t>
+	using int_arg = int;
+
+	template<std::size_t... Is>
+	void add_cell_callback( daw::parse_template<> &tmp, std::index_sequence<Is...> ) {
+		tmp.add_callback<int_arg<Is>...>( "cell", []( int_arg<Is>... values ) {
+			return ( 0 + ... + values );
+		} );
+	}
+
+	void add_callbacks( daw::parse_template<> &tmp, template_shape const &shape ) {
+		switch( shape.arg_count ) {
+		case 0:
+			add_cell_callback( tmp, std::make_index_sequence<0>{ } );
+			break;
+		case 1:
+			add_cell_callback( tmp, std::make_index_sequence<1>{ } );
+			break;
+		case 2:
+			add_cell_callback( tmp, std::make_index_sequence<2>{ } );
+			break;
+		default:
+			add_cell_callback( tmp, std::make_index_sequence<4>{ } );
+			break;
+		}
+		tmp.add_callback<daw::escaped_string>(
+		  "quote",
+		  []( std::string_view str, daw::io::WriteProxy &writer ) { (void)writer.write( str ); } );
+		tmp.finalize( );
+	}
+
+	struct result {
+		std::string group;
+		template_shape shape;
+		std::size_t threads;
+		std::size_t runs;
+		/// The bytes processed by one run
+		std::size_t bytes;
+		double ns_per_run;
+	};
+
+	/// Run func until at least min_time has passed, after a warmup run, and return the runs made
+	/// and the average time of one
+	template<typename Func>
+	std::pair<std::size_t, double> measure( Func &&func ) {
+		using clock_t = std::chrono::steady_clock;
+		constexpr auto min_time = std::chrono::milliseconds( 200 );
+		func( );
+		std::size_t runs = 0;
+		auto const start = clock_t::now( );
+		auto elapsed = clock_t::duration::zero( );
+		do {
+			func( );
+			++runs;
+			elapsed = clock_t::now( ) - start;
+		} while( elapsed < min_time );
+		auto const ns = std::chrono::duration<double, std::nano>( elapsed ).count( );
+		return { runs, ns / static_cast<double>( runs ) };
+	}
+
+	class bench_suite {
+		std::vector<result> m_results{ };
+
+		void add( std::string group,
+		          template_shape const &shape,
+		          std::size_t threads,
+		          std::size_t bytes,
+		          std::pair<std::size_t, double> timing ) {
+			auto const &r = m_results.emplace_back(
+			  result{ std::move( group ), shape, threads, timing.first, bytes, timing.second } );
+			auto const mb_per_sec =
+			  ( static_cast<double>( r.bytes ) / ( 1024.0 * 1024.0 ) ) / ( r.ns_per_run / 1e9 );
+			std::clog << std::left << std::setw( 10 ) << r.group << std::setw( 8 )
+			          << to_string( r.shape.mix ) << std::right << std::setw( 9 ) << r.shape.bytes
+			          << " B" << std::setw( 5 ) << r.shape.tags_per_kb << " tags/KB" << std::setw( 3 )
+			          << r.shape.arg_count << " args" << std::setw( 4 ) << r.threads << " thr"
+			          << std::fixed << std::setprecision( 1 ) << std::setw( 14 ) << r.ns_per_run
+			          << " ns/run" << std::setw( 10 ) << mb_per_sec << " MB/s\n";
+		}
+
+	public:
+		void compile( template_shape const &shape ) {
+			auto const str = generate( shape );
+			add( "compile", shape, 1, str.size( ), measure( [&] {
+				     auto tmp = daw::parse_template( str );
+				     daw::parse_template_bench::do_not_optimize( tmp );
+			     } ) );
+		}
+
+		void render( template_shape const &shape, std::size_t threads = 1 ) {
+			auto tmp = daw::parse_template( generate( shape ) );
+			add_callbacks( tmp, shape );
+			auto const bytes = tmp.to_string( ).size( );
+			if( threads == 1 ) {
+				auto out = std::string( );
+				add( "render", shape, 1, bytes, measure( [&] {
+					     tmp.render_into( out );
+					     daw::parse_template_bench::do_not_optimize( out );
+				     } ) );
+				return;
+			}
+			// Each run is one render on every thread, so bytes is for all of them
+			constexpr std::size_t renders_per_run = 64;
+			auto const &shared = tmp;
+			auto timing = measure( [&] {
+				auto workers = std::vector<std::thread>( );
+				for( std::size_t t = 0; t < threads; ++t ) {
+					workers.emplace_back( [&] {
+						auto out = std::string( );
+						for( std::size_t n = 0; n < renders_per_run; ++n ) {
+							shared.render_into( out );
+							daw::parse_template_bench::do_not_optimize( out );
+						}
+					} );
+				}
+				for( auto &worker : workers ) {
+					worker.join( );
+				}
+			} );
+			timing.second /= static_cast<double>( renders_per_run );
+			add( "threads", shape, threads, bytes * threads, timing );
+		}
+
+		void write_json( std::ostream &os ) const {
+			os << "{\n  \"library\": \"daw-parse-template\",\n  \"version\": \""
+			   << DAW_PARSE_TEMPLATE_VERSION << "\",\n  \"results\": [";
+			bool is_first = true;
+			for( auto const &r : m_results ) {
+				os << ( is_first ? "\n" : ",\n" );
+				is_first = false;
+				auto const mb_per_sec =
+				  ( static_cast<double>( r.bytes ) / ( 1024.0 * 1024.0 ) ) / ( r.ns_per_run / 1e9 );
+				os << "    {\"group\": \"" << r.group << "\", \"tags\": \"" << to_string( r.shape.mix )
+				   << "\", \"template_bytes\": " << r.shape.bytes
+				   << ", \"tags_per_kb\": " << r.shape.tags_per_kb
+				   << ", \"arg_count\": " << r.shape.arg_count << ", \"threads\": " << r.threads
+				   << ", \"runs\": " << r.runs << ", \"bytes\": " << r.bytes << std::fixed
+				   << std::setprecision( 1 ) << ", \"ns_per_run\": " << r.ns_per_run
+				   << ", \"mb_per_sec\": " << mb_per_sec << '}';
+			}
+			os << "\n  ]\n}\n";
+		}
+	};
+} // namespace
+
+int main( int argc, char const **argv ) {
+	auto suite = bench_suite( );
+	for( std::size_t bytes : { 4096U, 65536U, 1048576U } ) {
+		suite.compile( { bytes, 0, 0, tag_mix::none } );
+		suite.compile( { bytes, 16, 2, tag_mix::calls } );
+	}
+	for( std::size_t bytes : { 4096U, 65536U } ) {
+		suite.render( { bytes, 0, 0, tag_mix::none } );
+		for( std::size_t density : { 2U, 16U, 64U } ) {
+			suite.render( { bytes, density, 1, tag_mix::calls } );
+		}
+		for( std::size_t args : { 0U, 2U, 4U } ) {
+			suite.render( { bytes, 16, args, tag_mix::calls } );
+		}
+		suite.render( { bytes, 16, 0, tag_mix::times } );
+		suite.render( { bytes, 16, 0, tag_mix::escaped } );
+	}
+	auto const max_threads = std::max<std::size_t>( 1, std::thread::hardware_concurrency( ) );
+	for( std::size_t threads = 2; threads <= max_threads; threads *= 2 ) {
+		suite.render( { 65536, 16, 2, tag_mix::calls }, threads );
+	}
+
+	if( argc > 1 ) {
+		auto file = std::ofstream( argv[1] );
+		if( not file ) {
+			std::cerr << "Error opening file: " << argv[1] << std::endl;
+			return EXIT_FAILURE;
+		}
+		suite.write_json( file );
+	} else {
+		suite.write_json( std::cout );
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,56 @@
+// The MIT License (MIT)
+//
+// Copyright (c) Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+
+namespace daw::parse_template_test {
+	/// Print message when condition is false, returning condition so results can be combined
+	/// with &=
+	inline bool check( bool condition, char const *message ) {
+		if( not condition ) {
+			std::cerr << message << '\n';
+		}
+		return condition;
+	}
+
+	/// Whether func reports an error
+	template<typename Func>
+	bool throws( Func &&func ) {
+		try {
+			func( );
+		} catch( std::runtime_error const & ) { return true; }
+		return false;
+	}
+
+	/// The exit code of a test named name, whose checks all passed when ok is true
+	inline int test_result( char const *name, bool ok ) {
+		if( not ok ) {
+			return EXIT_FAILURE;
+		}
+		std::cout << name << " passed\n";
+		return EXIT_SUCCESS;
+	}
+} // namespace daw::parse_template_test
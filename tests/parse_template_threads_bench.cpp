@@ -0,0 +1,116 @@
+// The MIT License (MIT)
+//
+// Copyright (c) Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+// Renders one compiled template from 1 to N threads at once and reports the throughput and how
+// close it is to scaling linearly with the thread count
+
+#include <daw/daw_memory_mapped_file.h>
+#include <daw/daw_parse_template.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if not defined( DAW_TEST_TEMPLATE_PATH )
+#define DAW_TEST_TEMPLATE_PATH "test_template.shtml"
+#endif
+
+namespace {
+	struct render_state {
+		int step;
+		int count;
+	};
+
+	void add_callbacks( daw::parse_template<> &tmp ) {
+		tmp.add_callback( "dummy_text_cb", []( ) { return "This is some dummy text"; } );
+		tmp.add_callback<int, int, daw::escaped_string>(
+		  "dummy_text_cb2",
+		  []( int a, int b, std::string str ) {
+			  return "From " + std::to_string( a ) + " to " + std::to_string( b ) + " we say " + str;
+		  } );
+		tmp.add_callback<size_t, daw::escaped_string, daw::escaped_string>(
+		  "repeat_test",
+		  []( size_t how_many, std::string prefix, std::string suffix ) {
+			  auto result = std::string( );
+			  for( size_t n = 0; n < how_many; ++n ) {
+				  result += prefix + std::to_string( n ) + suffix;
+			  }
+			  return result;
+		  } );
+		tmp.add_stateful_callback<render_state>( "stateful_test", []( render_state &s ) {
+			s.count += s.step;
+			return s.count;
+		} );
+		tmp.finalize( );
+	}
+} // namespace
+
+int main( int argc, char const **argv ) {
+	auto const path = argc > 1 ? argv[1] : DAW_TEST_TEMPLATE_PATH;
+	auto const template_str = daw::filesystem::memory_mapped_file_t<char>( path );
+	if( not template_str ) {
+		std::cerr << "Error opening file: " << path << std::endl;
+		return EXIT_FAILURE;
+	}
+	auto compiled = daw::parse_template( template_str );
+	add_callbacks( compiled );
+	auto const &shared = compiled;
+
+	constexpr std::size_t renders_per_thread = 20'000;
+	auto const max_threads = std::max( 1U, std::thread::hardware_concurrency( ) );
+	double single_thread_rate = 0.0;
+	std::cout << std::setw( 8 ) << "threads" << std::setw( 16 ) << "renders/s" << std::setw( 12 )
+	          << "scaling\n";
+	for( unsigned thread_count = 1; thread_count <= max_threads; thread_count *= 2 ) {
+		auto threads = std::vector<std::thread>( );
+		auto const start = std::chrono::steady_clock::now( );
+		for( unsigned t = 0; t < thread_count; ++t ) {
+			threads.emplace_back( [&] {
+				auto state = render_state{ 1, 0 };
+				auto out = std::string( );
+				for( std::size_t n = 0; n < renders_per_thread; ++n ) {
+					out.clear( );
+					shared.write_to( out, state );
+				}
+			} );
+		}
+		for( auto &t : threads ) {
+			t.join( );
+		}
+		auto const elapsed =
+		  std::chrono::duration<double>( std::chrono::steady_clock::now( ) - start ).count( );
+		auto const rate = static_cast<double>( renders_per_thread * thread_count ) / elapsed;
+		if( thread_count == 1 ) {
+			single_thread_rate = rate;
+		}
+		std::cout << std::setw( 8 ) << thread_count << std::setw( 16 ) << std::fixed
+		          << std::setprecision( 0 ) << rate << std::setw( 11 ) << std::setprecision( 2 )
+		          << ( rate / ( single_thread_rate * thread_count ) ) << '\n';
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,134 @@
+// The MIT License (MIT)
+//
+// Copyright (c) Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+// Measures time zone lookups for the five zones used by test_template.shtml.  Compares locating
+// a zone by name with resolving it, and finding the UTC offset through date::time_zone::get_info
+// with the binary search of a resolved zone's transitions
+
+#include "parse_template_bench.h"
+
+#include <daw/daw_memory_mapped_file.h>
+#include <daw/daw_parse_template.h>
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#if not defined( DAW_TEST_TEMPLATE_PATH )
+#define DAW_TEST_TEMPLATE_PATH "test_template.shtml"
+#endif
+
+namespace {
+	constexpr std::array<char const *, 4> zone_names = {
+	  "Europe/Berlin", "America/New_York", "Antarctica/South_Pole", "Etc/GMT-12" };
+
+	/// Times spread over the next year, so that lookups land in different transitions
+	constexpr std::size_t time_count = 1'024;
+	std::array<date::sys_seconds, time_count> spread_times( ) {
+		using namespace std::chrono;
+		auto result = std::array<date::sys_seconds, time_count>{ };
+		auto const now = floor<seconds>( system_clock::now( ) );
+		for( std::size_t n = 0; n < time_count; ++n ) {
+			result[n] = now + seconds( static_cast<std::int64_t>( n ) * 30'817 );
+		}
+		return result;
+	}
+} // namespace
+
+int main( int argc, char const **argv ) {
+	auto const path = argc > 1 ? argv[1] : DAW_TEST_TEMPLATE_PATH;
+	auto const template_str = daw::filesystem::memory_mapped_file_t<char>( path );
+	if( not template_str ) {
+		std::cerr << "Error opening file: " << path << std::endl;
+		return EXIT_FAILURE;
+	}
+	auto const template_view = daw::string_view( template_str.data( ), template_str.size( ) );
+
+	// The first template loads the time zone database and resolves each zone
+	auto const cold_start = std::chrono::steady_clock::now( );
+	auto const first = daw::parse_template( template_view );
+	auto const cold_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+	                       std::chrono::steady_clock::now( ) - cold_start )
+	                       .count( );
+	daw::parse_template_bench::do_not_optimize( first );
+	std::cout << "first compile, resolving the zones: " << cold_ns << " ns\n";
+
+	constexpr std::size_t runs = 10'000;
+	daw::parse_template_bench::bench( "compile test_template.shtml",
+	                                  template_view.size( ),
+	                                  runs,
+	                                  [&] {
+		                                  auto const tmp = daw::parse_template( template_view );
+		                                  daw::parse_template_bench::do_not_optimize( tmp );
+	                                  } );
+
+	daw::parse_template_bench::bench( "date::locate_zone x5", 0, runs, [] {
+		for( auto name : zone_names ) {
+			daw::parse_template_bench::do_not_optimize( date::locate_zone( name ) );
+		}
+		daw::parse_template_bench::do_not_optimize( date::current_zone( ) );
+	} );
+	daw::parse_template_bench::bench( "resolve_zone x5", 0, runs, [] {
+		using daw::parse_template_impl::resolve_zone;
+		for( auto name : zone_names ) {
+			daw::parse_template_bench::do_not_optimize( &resolve_zone( name ) );
+		}
+		daw::parse_template_bench::do_not_optimize( &resolve_zone( "" ) );
+	} );
+
+	auto const times = spread_times( );
+	using zone_ptr = daw::parse_template_impl::resolved_zone const *;
+	auto zones = std::array<zone_ptr, zone_names.size( ) + 1>{ };
+	for( std::size_t n = 0; n < zone_names.size( ); ++n ) {
+		zones[n] = &daw::parse_template_impl::resolve_zone( zone_names[n] );
+	}
+	zones.back( ) = &daw::parse_template_impl::resolve_zone( "" );
+	constexpr std::size_t offset_runs = 200;
+	auto const lookups = static_cast<double>( zones.size( ) * times.size( ) );
+	auto const per_lookup = [&]( daw::parse_template_bench::bench_result const &result ) {
+		std::cout << "    " << ( result.ns_per_run / lookups ) << " ns/lookup\n";
+	};
+	per_lookup( daw::parse_template_bench::bench( "time_zone::get_info", 0, offset_runs, [&] {
+		auto total = std::chrono::seconds( 0 );
+		for( auto const *zone : zones ) {
+			for( auto tp : times ) {
+				total += zone->tz( )->get_info( tp ).offset;
+			}
+		}
+		daw::parse_template_bench::do_not_optimize( total );
+	} ) );
+	per_lookup( daw::parse_template_bench::bench( "resolved_zone::info", 0, offset_runs, [&] {
+		auto total = std::chrono::seconds( 0 );
+		auto fallback = date::sys_info{ };
+		for( auto const *zone : zones ) {
+			for( auto tp : times ) {
+				total += zone->info( tp, fallback ).offset;
+			}
+		}
+		daw::parse_template_bench::do_not_optimize( total );
+	} ) );
+	return EXIT_SUCCESS;
+}
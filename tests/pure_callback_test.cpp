@@ -0,0 +1,120 @@
+// The MIT License (MIT)
+//
+// Copyright (c) Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+// Checks that pure callbacks are evaluated once for each distinct set of arguments, and again
+// after their handle is invalidated or their ttl passes, including while rendering on other
+// threads
+
+#include "parse_template_test.h"
+
+#include <daw/daw_parse_template.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using daw::parse_template_test::check;
+
+int main( ) {
+	bool ok = true;
+	auto const calls = std::make_shared<std::atomic<int>>( 0 );
+	auto const version = std::make_shared<std::atomic<int>>( 1 );
+
+	auto tmp = daw::parse_template(
+	  "<%call args=\"build\"%>|<%call args=\"label,1\"%>|<%call args=\"label,2\"%>|"
+	  "<%call escape=\"html\" args=\"label,1\"%>|<%call args=\"build\"%>\n" );
+	auto const handle = tmp.add_pure_callback( "build", [=] {
+		++*calls;
+		return "v" + std::to_string( version->load( ) );
+	} );
+	tmp.add_pure_callback<int>( "label", [=]( int n ) {
+		++*calls;
+		return "<" + std::to_string( n ) + ">";
+	} );
+	tmp.finalize( );
+
+	ok &= check( tmp.to_string( ) == "v1|<1>|<2>|&lt;1&gt;|v1\n", "Unexpected output" );
+	ok &= check( *calls == 3, "Expected one evaluation for each distinct set of arguments" );
+	ok &= check( tmp.to_string( ) == "v1|<1>|<2>|&lt;1&gt;|v1\n", "Unexpected cached output" );
+	ok &= check( *calls == 3, "Expected cached values to be reused" );
+
+	*version = 2;
+	handle.invalidate( );
+	ok &= check( tmp.to_string( ) == "v2|<1>|<2>|&lt;1&gt;|v2\n", "Unexpected invalidated output" );
+	ok &= check( *calls == 4, "Expected only the invalidated callback to be evaluated" );
+
+	// A handle shared by templates
+	auto other = daw::parse_template( "<%call args=\"flag\"%>\n" );
+	auto const flag = std::make_shared<std::atomic<bool>>( false );
+	other.add_pure_callback( "flag", [=] { return flag->load( ) ? "on" : "off"; }, handle );
+	ok &= check( other.to_string( ) == "off\n", "Unexpected flag" );
+	*flag = true;
+	ok &= check( other.to_string( ) == "off\n", "Expected the cached flag" );
+	handle.invalidate( );
+	ok &= check( other.to_string( ) == "on\n", "Expected the refreshed flag" );
+
+	// Values expire after their ttl
+	auto timed = daw::parse_template( "<%call args=\"now\"%>\n" );
+	auto const ticks = std::make_shared<std::atomic<int>>( 0 );
+	(void)timed.add_pure_callback(
+	  "now",
+	  [=] { return std::to_string( ++*ticks ); },
+	  std::chrono::seconds( 1 ) );
+	ok &= check( timed.to_string( ) == "1\n" and timed.to_string( ) == "1\n",
+	             "Expected the value to be cached within its ttl" );
+	std::this_thread::sleep_for( std::chrono::milliseconds( 1100 ) );
+	ok &= check( timed.to_string( ) == "2\n", "Expected the value to be evaluated after its ttl" );
+
+	// Invalidating while other threads render
+	auto stop = std::atomic<bool>( false );
+	auto bad_renders = std::atomic<int>( 0 );
+	auto threads = std::vector<std::thread>( );
+	for( int t = 0; t < 4; ++t ) {
+		threads.emplace_back( [&] {
+			auto out = std::string( );
+			while( not stop ) {
+				tmp.render_into( out );
+				if( out.size( ) < 2 or out[0] != 'v' ) {
+					++bad_renders;
+				}
+			}
+		} );
+	}
+	for( int n = 3; n < 200; ++n ) {
+		*version = n;
+		handle.invalidate( );
+		std::this_thread::yield( );
+	}
+	stop = true;
+	for( auto &t : threads ) {
+		t.join( );
+	}
+	ok &= check( bad_renders == 0, "Unexpected output while invalidating" );
+	ok &= check( tmp.to_string( ) == "v199|<1>|<2>|&lt;1&gt;|v199\n",
+	             "Expected the last value after invalidating" );
+
+	return daw::parse_template_test::test_result( "pure_callback_test", ok );
+}
@@ -0,0 +1,101 @@
+// The MIT License (MIT)
+//
+// Copyright (c) Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+// Checks that render_batch produces the same output as rendering each state with to_string
+
+#include <daw/daw_parse_template.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+	struct recipient {
+		std::string name;
+		int amount;
+		int renders;
+	};
+} // namespace
+
+int main( ) {
+	auto tmp = daw::parse_template(
+	  "Dear <%call args=\"name\"%>,\nYou owe $<%call args=\"amount\"%>.\nRender "
+	  "<%call args=\"renders\"%>\n" );
+	tmp.add_stateful_callback<recipient>( "name", []( recipient &r ) { return r.name; } );
+	tmp.add_stateful_callback<recipient>( "amount", []( recipient &r ) { return r.amount * 100; } );
+	tmp.add_stateful_callback<recipient>( "renders", []( recipient &r ) { return ++r.renders; } );
+	tmp.finalize( );
+
+	auto make_states = [] {
+		auto result = std::vector<recipient>( );
+		for( int n = 0; n < 1000; ++n ) {
+			result.push_back( recipient{ "Person " + std::to_string( n ), n, 0 } );
+		}
+		return result;
+	};
+
+	auto expected_states = make_states( );
+	auto expected = std::vector<std::string>( );
+	for( auto &state : expected_states ) {
+		expected.push_back( tmp.to_string( state ) );
+	}
+
+	auto states = make_states( );
+	auto output = daw::render_batch_output( );
+	tmp.render_batch( states, output );
+	if( output.size( ) != expected.size( ) ) {
+		std::cerr << "Unexpected item count " << output.size( ) << '\n';
+		return EXIT_FAILURE;
+	}
+	for( std::size_t n = 0; n < expected.size( ); ++n ) {
+		if( output[n] != daw::string_view( expected[n].data( ), expected[n].size( ) ) ) {
+			std::cerr << "Mismatch for item " << n << '\n';
+			return EXIT_FAILURE;
+		}
+	}
+
+	// The sink form sees the same items, and the states are updated by both renders
+	std::size_t matched = 0;
+	auto const sink = [&]( std::size_t index, daw::string_view item ) {
+		auto again = expected[index];
+		again.replace( again.rfind( '1' ), 1, "2" );
+		if( item == daw::string_view( again.data( ), again.size( ) ) ) {
+			++matched;
+		}
+	};
+	tmp.render_batch( states.begin( ), states.end( ), sink );
+	if( matched != expected.size( ) ) {
+		std::cerr << "Sink output mismatch, " << matched << " items matched\n";
+		return EXIT_FAILURE;
+	}
+
+	auto empty = std::vector<recipient>( );
+	tmp.render_batch( empty, output );
+	if( output.size( ) != 0 ) {
+		std::cerr << "An empty batch has items\n";
+		return EXIT_FAILURE;
+	}
+	std::cout << "render_batch_test passed\n";
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,138 @@
+// The MIT License (MIT)
+//
+// Copyright (c) Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+// Checks that profile_to counts the calls, bytes, and errors of each tag and that snapshots export
+// them
+
+#include "parse_template_test.h"
+
+#include <daw/daw_parse_template.h>
+#include <daw/daw_render_profile.h>
+
+#include <stdexcept>
+#include <string>
+
+using daw::parse_template_test::check;
+
+namespace {
+	struct page {
+		int items;
+		bool fail;
+	};
+
+	bool contains( std::string const &str, char const *part ) {
+		return str.find( part ) != std::string::npos;
+	}
+} // namespace
+
+int main( ) {
+	bool ok = true;
+
+	auto const source = std::string(
+	  "<h1><%call args=\"title\"%></h1><%each args=\"items\"%><i><%call args=\"item\"%></i>"
+	  "<%endeach%><%date%>\n" );
+	auto tmp = daw::parse_template( source );
+	tmp.add_callback<>( "title", []( ) { return std::string( "Title" ); } );
+	tmp.add_stateful_block_callback<page>( "items", []( page &p ) { return p.items; } );
+	tmp.add_stateful_callback<page>( "item", []( page &p ) {
+		if( p.fail ) {
+			throw std::runtime_error( "item failed" );
+		}
+		return 42;
+	} );
+
+	auto profile = tmp.make_profile( );
+	ok &= check( profile.size( ) == 3, "Expected a counter for each call and date tag" );
+
+	auto state = page{ 3, false };
+	auto out = std::string( );
+	auto writer = daw::io::WriteProxy( out );
+	tmp.profile_to( writer, profile, state );
+	ok &= check( out == tmp.to_string( state ), "Profiled output differs from to_string" );
+
+	auto snapshot = profile.snapshot( );
+	ok &= check( snapshot[0].tag.name == "title" and
+	               snapshot[0].tag.offset == source.find( "<%call" ),
+	             "Unexpected title tag" );
+	ok &= check( snapshot[1].tag.name == "item" and
+	               snapshot[1].tag.offset == source.find( "<%call args=\"item" ),
+	             "Unexpected item tag" );
+	ok &= check( snapshot[2].tag.name == "date" and snapshot[2].tag.offset == source.find( "<%date" ),
+	             "Unexpected date tag" );
+	ok &= check( snapshot[0].calls == 1 and snapshot[0].bytes == 5, "Unexpected title counters" );
+	ok &= check( snapshot[1].calls == 3 and snapshot[1].bytes == 6, "Unexpected item counters" );
+	ok &= check( snapshot[2].calls == 1 and snapshot[2].bytes == 10, "Unexpected date counters" );
+	std::uint64_t histogram_calls = 0;
+	for( auto count : snapshot[1].histogram ) {
+		histogram_calls += count;
+	}
+	ok &= check( histogram_calls == 3, "Expected each call in the histogram" );
+
+	// A callback throwing is counted as an error and the exception still propagates
+	state.fail = true;
+	bool threw = false;
+	try {
+		out.clear( );
+		tmp.profile_to( writer, profile, state );
+	} catch( std::runtime_error const & ) { threw = true; }
+	ok &= check( threw, "Expected the callback exception" );
+	snapshot = profile.snapshot( );
+	ok &= check( snapshot[1].calls == 4 and snapshot[1].errors == 1, "Expected an error count" );
+
+	auto const text = profile.to_text( );
+	ok &= check( contains( text, "item @" ) and contains( text, "calls=4 errors=1" ),
+	             "Unexpected text snapshot" );
+	auto const json = profile.to_json( );
+	ok &= check( contains( json, "{\"name\":\"item\",\"offset\":" ) and
+	               contains( json, "\"calls\":4,\"errors\":1" ) and
+	               contains( json, "\"bucket_limits_ns\":[256,512," ),
+	             "Unexpected JSON snapshot" );
+
+	profile.reset( );
+	ok &= check( profile.snapshot( )[1].calls == 0, "Expected reset to clear the counters" );
+
+	// Tags inside a cache block are profiled when the block is rendered and not when it is replayed
+	auto cached = daw::parse_template( "<%cache args=\"k\"%><%call args=\"title\"%><%endcache%>" );
+	cached.add_callback<>( "title", []( ) { return std::string( "Title" ); } );
+	auto cached_profile = cached.make_profile( );
+	for( int i = 0; i < 2; ++i ) {
+		out.clear( );
+		cached.profile_to( writer, cached_profile );
+		ok &= check( out == "Title", "Unexpected cached output" );
+	}
+	snapshot = cached_profile.snapshot( );
+	ok &= check( snapshot[0].calls == 1 and snapshot[0].bytes == 5,
+	             "Expected the tag in the cache block to be profiled once" );
+
+	// A profile only fits the template it was made for
+	auto other = daw::parse_template( "<%call args=\"title\"%>" );
+	other.add_callback<>( "title", []( ) { return std::string( "Title" ); } );
+	threw = false;
+	try {
+		out.clear( );
+		other.profile_to( writer, profile );
+	} catch( std::runtime_error const & ) { threw = true; }
+	ok &= check( threw, "Expected a mismatched profile to be an error" );
+
+	return daw::parse_template_test::test_result( "render_profile_test", ok );
+}
@@ -0,0 +1,95 @@
+// The MIT License (MIT)
+//
+// Copyright (c) Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+// Checks the delimiter scanners give the same results at every supported instruction set,
+// including matches that straddle or end at a vector block boundary
+
+#include <daw/daw_parse_template_scan.h>
+
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+
+namespace {
+	std::size_t reference_find_pair( std::string const &str, char c0, char c1 ) {
+		for( std::size_t n = 0; n + 1 < str.size( ); ++n ) {
+			if( str[n] == c0 and str[n + 1] == c1 ) {
+				return n;
+			}
+		}
+		return daw::string_view::npos;
+	}
+
+	std::size_t reference_find_first_of( std::string const &str, char c0, char c1, char c2 ) {
+		for( std::size_t n = 0; n < str.size( ); ++n ) {
+			if( str[n] == c0 or str[n] == c1 or str[n] == c2 ) {
+				return n;
+			}
+		}
+		return daw::string_view::npos;
+	}
+} // namespace
+
+int main( ) {
+	using daw::parse_template_impl::simd_level;
+	auto rng = std::mt19937( 42 );
+	// A small alphabet so that matches are common
+	auto const alphabet = std::string( "ab<%>\",\\" );
+	auto pick = std::uniform_int_distribution<std::size_t>( 0, alphabet.size( ) - 1 );
+	// Mostly filler, so that matches are found at every offset in a block
+	auto sparse = std::uniform_int_distribution<int>( 0, 40 );
+
+	std::size_t failures = 0;
+	std::size_t checks = 0;
+	for( auto level : { simd_level::scalar, simd_level::sse2, simd_level::avx2 } ) {
+		if( daw::parse_template_impl::set_simd_level( level ) != level ) {
+			continue;
+		}
+		for( std::size_t size = 0; size < 200; ++size ) {
+			for( int iteration = 0; iteration < 50; ++iteration ) {
+				auto str = std::string( size, 'x' );
+				for( auto &c : str ) {
+					if( sparse( rng ) == 0 ) {
+						c = alphabet[pick( rng )];
+					}
+				}
+				auto const sv = daw::string_view( str.data( ), str.size( ) );
+				++checks;
+				if( daw::parse_template_impl::find_pair( sv, '<', '%' ) !=
+				      reference_find_pair( str, '<', '%' ) or
+				    daw::parse_template_impl::find_pair( sv, '%', '>' ) !=
+				      reference_find_pair( str, '%', '>' ) or
+				    daw::parse_template_impl::find_first_of( sv, '"', '\\', ',' ) !=
+				      reference_find_first_of( str, '"', '\\', ',' ) ) {
+					std::cerr << "Mismatch at level " << static_cast<int>( level ) << " for '" << str
+					          << "'\n";
+					++failures;
+				}
+			}
+		}
+	}
+	std::cout << checks << " checks, " << failures << " failures\n";
+	return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,111 @@
+// The MIT License (MIT)
+//
+// Copyright (c) Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+// Checks that size_hint follows the output size of recent renders and that rendering into a reused
+// string stops reallocating once it has grown
+
+#include "parse_template_test.h"
+
+#include <daw/daw_parse_template.h>
+
+#include <string>
+#include <vector>
+
+using daw::parse_template_test::check;
+
+int main( ) {
+	bool ok = true;
+
+	auto tmp = daw::parse_template( "<div><%call args=\"body\"%></div>\n" );
+	tmp.add_stateful_callback<std::size_t>( "body", []( std::size_t &size ) {
+		return std::string( size, 'x' );
+	} );
+	ok &= check( tmp.size_hint( ) == tmp.size_estimate( ), "Expected the estimate before rendering" );
+
+	// The hint rises at once to a larger output
+	std::size_t size = 5000;
+	auto const large = tmp.to_string( size );
+	ok &= check( tmp.size_hint( ) == large.size( ), "Expected the hint to rise to the output size" );
+
+	// and decays towards smaller ones without going below them
+	size = 100;
+	auto const small = tmp.to_string( size ).size( );
+	auto const decayed = tmp.size_hint( );
+	ok &= check( decayed < large.size( ) and decayed > small, "Expected the hint to decay" );
+	for( int n = 0; n < 200; ++n ) {
+		(void)tmp.to_string( size );
+	}
+	ok &= check( tmp.size_hint( ) >= small and tmp.size_hint( ) < small + 8,
+	             "Expected the hint to settle on the output size" );
+
+	// Rendering into a reused string keeps its buffer in steady state
+	auto reuse = std::string( );
+	size = 3000;
+	tmp.render_into( reuse, size );
+	auto const *const data = reuse.data( );
+	auto const capacity = reuse.capacity( );
+	for( int n = 0; n < 10; ++n ) {
+		size = 2000 + static_cast<std::size_t>( n ) * 100;
+		auto const &result = tmp.render_into( reuse, size );
+		ok &= check( &result == &reuse and result.size( ) == size + 12, "Unexpected reuse output" );
+	}
+	ok &= check( reuse.data( ) == data and reuse.capacity( ) == capacity,
+	             "Expected the reused string to keep its buffer" );
+
+	// A fresh string is reserved from the hint
+	ok &= check( tmp.to_string( size ).capacity( ) >= tmp.size_hint( ),
+	             "Expected to_string to reserve the hint" );
+
+	// Batches feed the hint too
+	auto sizes = std::vector<std::size_t>{ 7000, 7000 };
+	auto output = daw::render_batch_output( );
+	tmp.render_batch( sizes, output );
+	ok &= check( tmp.size_hint( ) == 7012, "Expected render_batch to update the hint" );
+
+	// Appending many renders to one string grows it geometrically
+	auto appended = std::string( );
+	auto reallocations = 0;
+	for( int n = 0; n < 1000; ++n ) {
+		auto const before = appended.capacity( );
+		tmp.write_to( appended, size );
+		reallocations += appended.capacity( ) != before ? 1 : 0;
+	}
+	ok &= check( appended.size( ) == 1000 * ( size + 12 ) and reallocations < 32,
+	             "Expected appending to reallocate rarely" );
+
+	// Without a state
+	auto fixed = daw::parse_template( "<p>fixed</p>" );
+	ok &= check( fixed.render_into( reuse ) == "<p>fixed</p>" and fixed.size_hint( ) == 12,
+	             "Unexpected stateless output" );
+
+	// A std::string state is passed to the callbacks, not rendered into
+	auto named = daw::parse_template( "[<%call args=\"name\"%>]" );
+	named.add_stateful_callback<std::string>( "name", []( std::string &name ) { return name; } );
+	auto name = std::string( "alice" );
+	ok &= check( named.to_string( name ) == "[alice]" and name == "alice",
+	             "Expected to_string to pass a std::string state" );
+	ok &= check( named.render_into( reuse, name ) == "[alice]",
+	             "Unexpected std::string state output" );
+
+	return daw::parse_template_test::test_result( "size_hint_test", ok );
+}
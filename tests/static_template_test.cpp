@@ -0,0 +1,122 @@
+// The MIT License (MIT)
+//
+// Copyright (c) Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+// Checks that a template compiled at compile time renders the same output as the same template
+// compiled at runtime with parse_template
+
+#include <daw/daw_parse_template.h>
+#include <daw/daw_static_template.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+namespace {
+	struct render_state {
+		int step;
+		int count;
+	};
+
+#define TEST_TEMPLATE                                                                       \
+	"<ul>\n"                                                                                  \
+	"  <li><%call args=\"dummy_text_cb\"%></li>\n"                                            \
+	"  <li><%call args=\"dummy_text_cb2,1,3,\\\"hello\\\"\"%></li>\n"                         \
+	"  <li><%call args=\"repeat_test,3,\\\"<b>\\\",\\\"</b>\\\"\"%></li>\n"                   \
+	"  <li><%call args=\"echo,\\\"tab\\\\there\\\"\"%></li>\n"                                \
+	"  <li><%call args=\"stateful_test\"%> <%call args=\"stateful_test\"%></li>\n"            \
+	"  <li><%   call args=\"negate,-42\"%></li>\n"                                            \
+	"  <li><%timestamp args=\"%Y,Etc/UTC\"%></li>\n"                                          \
+	"</ul>\n"
+
+	constexpr auto dummy_text_cb = []( ) {
+		return "This is some dummy text";
+	};
+	constexpr auto dummy_text_cb2 = []( int a, int b, std::string str ) {
+		return "From " + std::to_string( a ) + " to " + std::to_string( b ) + " we say " + str;
+	};
+	constexpr auto repeat_test = []( size_t how_many, std::string prefix, std::string suffix ) {
+		auto result = std::string( );
+		for( size_t n = 0; n < how_many; ++n ) {
+			result += prefix + std::to_string( n ) + suffix;
+		}
+		return result;
+	};
+	// Takes a view, so the static template passes the unescaped text without copying it
+	constexpr auto echo = []( std::string_view str, daw::io::WriteProxy &writer ) {
+		(void)writer.write( { "[", str, "]" } );
+	};
+	constexpr auto stateful_test = []( render_state &s ) {
+		s.count += s.step;
+		return s.count;
+	};
+	constexpr auto negate = []( long value ) {
+		return -value;
+	};
+} // namespace
+
+int main( ) {
+	static constexpr auto compiled = daw::static_template<TEST_TEMPLATE>( );
+	auto const callbacks = daw::make_static_callbacks(
+	  daw::static_callback<"dummy_text_cb">( dummy_text_cb ),
+	  daw::static_callback<"dummy_text_cb2", int, int, daw::escaped_string>( dummy_text_cb2 ),
+	  daw::static_callback<"repeat_test", size_t, daw::escaped_string, daw::escaped_string>(
+	    repeat_test ),
+	  daw::static_callback<"echo", daw::escaped_string>( echo ),
+	  daw::static_stateful_callback<"stateful_test", render_state>( stateful_test ),
+	  daw::static_callback<"negate", long>( negate ) );
+
+	auto runtime = daw::parse_template( TEST_TEMPLATE );
+	runtime.add_callback( "dummy_text_cb", dummy_text_cb );
+	runtime.add_callback<int, int, daw::escaped_string>( "dummy_text_cb2", dummy_text_cb2 );
+	runtime.add_callback<size_t, daw::escaped_string, daw::escaped_string>( "repeat_test",
+	                                                                          repeat_test );
+	runtime.add_callback<daw::escaped_string>(
+	  "echo",
+	  []( std::string str, daw::io::WriteProxy &writer ) { echo( str, writer ); } );
+	runtime.add_stateful_callback<render_state>( "stateful_test", stateful_test );
+	runtime.add_callback<long>( "negate", negate );
+	runtime.finalize( );
+
+	static_assert( compiled.static_size( ) > 0 );
+	if( compiled.static_size( ) != runtime.static_size( ) ) {
+		std::cerr << "static_size differs: " << compiled.static_size( ) << " vs "
+		          << runtime.static_size( ) << '\n';
+		return EXIT_FAILURE;
+	}
+
+	auto static_state = render_state{ 2, 0 };
+	auto runtime_state = render_state{ 2, 0 };
+	for( int n = 0; n < 2; ++n ) {
+		auto const expected = runtime.to_string( runtime_state );
+		auto const result = compiled.to_string( callbacks, static_state );
+		if( result != expected ) {
+			std::cerr << "Output mismatch\nstatic_template:\n"
+			          << result << "\nparse_template:\n"
+			          << expected << '\n';
+			return EXIT_FAILURE;
+		}
+	}
+	std::cout << "static_template_test passed\n";
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,151 @@
+// The MIT License (MIT)
+//
+// Copyright (c) Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+// Checks that a template loaded from its image renders and serializes as the compiled template
+// does, and that damaged images are rejected
+
+#include "parse_template_test.h"
+
+#include <daw/daw_parse_template.h>
+#include <daw/daw_template_image_file.h>
+#include <daw/daw_template_includes.h>
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <string>
+
+using daw::parse_template_test::check;
+using daw::parse_template_test::throws;
+
+namespace {
+	template<typename Template>
+	void add_callbacks( Template &tmp ) {
+		tmp.add_callback( "user", [] { return "<alice>"; } );
+		tmp.template add_callback<int, daw::escaped_string>(
+		  "repeat",
+		  []( int n, std::string const &s ) {
+			  auto result = std::string( );
+			  for( int i = 0; i < n; ++i ) {
+				  result += s;
+			  }
+			  return result;
+		  } );
+		tmp.template add_block_callback<>( "rows", [] { return 3; } );
+		tmp.template add_block_callback<bool>( "show", []( bool b ) { return b; } );
+		tmp.finalize( );
+	}
+
+	bool is_loadable( std::string const &image ) {
+		return not throws( [&] {
+			(void)daw::parse_template( daw::template_image, image );
+		} );
+	}
+
+	/// image with the byte at offset replaced
+	std::string patched( std::string image, std::size_t offset, char value ) {
+		image[offset] = value;
+		return image;
+	}
+} // namespace
+
+int main( ) {
+	bool ok = true;
+	auto includes = daw::template_includes( );
+	includes.add( "header", "<header><%call escape=\"html\" args=\"user\"%></header>" );
+	auto const source = std::string(
+	  "<%include args=\"header\"%><ul><%each args=\"rows\"%><li><%call args=\"repeat,2,\\\"ab\\\"\"%>"
+	  "</li><%endeach%></ul><%if args=\"show,true\"%>yes<%else%>no<%endif%>"
+	  "<%cache args=\"footer,60\"%><footer/><%endcache%><%flush%>"
+	  "<%if args=\"show,false\"%>hidden<%endif%>\n" );
+	auto compiled = includes.compile( source );
+	compiled.set_default_escape( daw::escape_mode::attr );
+	add_callbacks( compiled );
+	auto const image = compiled.to_image( );
+
+	auto loaded = daw::parse_template( daw::template_image, image );
+	add_callbacks( loaded );
+	ok &= check( loaded.default_escape( ) == daw::escape_mode::attr, "Unexpected default escape" );
+	ok &= check( loaded.to_string( ) == compiled.to_string( ), "Unexpected output after loading" );
+	ok &= check( loaded.to_string( ) ==
+	               "<header>&lt;alice&gt;</header><ul><li>abab</li><li>abab</li><li>abab</li></ul>yes"
+	               "<footer/>\n",
+	             "Unexpected output" );
+	ok &= check( loaded.to_image( ) == image, "Image of the loaded template differs" );
+	ok &= check( loaded.static_size( ) == compiled.static_size( ) and
+	               loaded.size_estimate( ) == compiled.size_estimate( ),
+	             "Unexpected size estimates after loading" );
+
+	// Time zones are stored by name and the system's time zone as the system's
+	auto times = daw::parse_template(
+	  "<%date args=\"America/Toronto\"%> <%time%> <%timestamp args=\"%Y,Europe/Paris\"%>\n" );
+	auto const times_image = times.to_image( );
+	auto loaded_times = daw::parse_template( daw::template_image, times_image );
+	ok &= check( loaded_times.to_image( ) == times_image, "Image with time zones differs" );
+
+	// Missing callbacks are reported as for a compiled template
+	auto unbound = daw::parse_template( daw::template_image, image );
+	ok &= check( throws( [&] { unbound.finalize( ); } ), "Expected an error for missing callbacks" );
+
+	ok &= check( not is_loadable( image.substr( 0, image.size( ) - 1 ) ),
+	             "Expected an error for a truncated image" );
+	ok &= check( not is_loadable( image + ' ' ), "Expected an error for trailing data" );
+	ok &= check( not is_loadable( patched( image, 0, 'X' ) ), "Expected an error for bad magic" );
+	ok &= check( not is_loadable( patched( image, 8, 99 ) ), "Expected an error for a new version" );
+	ok &= check( not is_loadable( patched( image, 11, 9 ) ), "Expected an error for byte order" );
+
+	// Records follow the header and start with the op.  The program is header text, call, header
+	// text, each, ...
+	auto const header_size = daw::parse_template_impl::image_header_size;
+	auto const record_size = daw::parse_template_impl::image_record_size;
+	ok &= check( not is_loadable( patched( image, header_size, 100 ) ),
+	             "Expected an error for an unknown op" );
+	ok &= check( not is_loadable( patched( image, header_size + 7, 100 ) ),
+	             "Expected an error for text out of range" );
+	ok &= check( not is_loadable( patched( image, header_size + record_size + 1, 9 ) ),
+	             "Expected an error for an unknown escape" );
+	auto const each_record = header_size + 3 * record_size;
+	ok &= check( image[each_record] ==
+	               static_cast<char>( daw::parse_template_impl::op_code::each_begin ),
+	             "Unexpected program layout" );
+	ok &= check( not is_loadable(
+	               patched( image,
+	                        each_record,
+	                        static_cast<char>( daw::parse_template_impl::op_code::cache_end ) ) ),
+	             "Expected an error for an unmatched block end" );
+	ok &= check( not is_loadable( patched(
+	               image,
+	               each_record,
+	               static_cast<char>( daw::parse_template_impl::op_code::cache_begin ) ) ),
+	             "Expected an error for mismatched blocks" );
+
+	// Through a file
+	auto const path = std::filesystem::temp_directory_path( ) / "daw_template_image_test.bin";
+	daw::save_template_image( compiled, path );
+	auto from_file = daw::load_template_image( path );
+	add_callbacks( from_file );
+	ok &= check( from_file.to_string( ) == compiled.to_string( ), "Unexpected output from a file" );
+	std::filesystem::remove( path );
+
+	return daw::parse_template_test::test_result( "template_image_test", ok );
+}
@@ -0,0 +1,98 @@
+// The MIT License (MIT)
+//
+// Copyright (c) Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+// Checks that <%include%> splices included templates into the including one, merging literal
+// text across the boundaries, and that unknown includes and include cycles are errors
+
+#include "parse_template_test.h"
+
+#include <daw/daw_template_includes.h>
+
+#include <stdexcept>
+#include <string>
+
+using daw::parse_template_test::check;
+
+namespace {
+	template<typename Func>
+	std::string error_from( Func &&func ) {
+		try {
+			func( );
+		} catch( std::runtime_error const &ex ) { return ex.what( ); }
+		return { };
+	}
+} // namespace
+
+int main( ) {
+	bool ok = true;
+	auto includes = daw::template_includes( );
+	includes.add( "header", "<html><body><%include args=\"nav\"%>" );
+	includes.add( "nav", "<nav><%call args=\"user\"%></nav>" );
+	includes.add( "footer",
+	              "<%cache args=\"footer\"%><footer>(c)</footer><%endcache%></body></html>" );
+
+	auto page = includes.compile( "<%include args=\"header\"%><main><%call args=\"body,5\"%></main>"
+	                              "<%include args=\"footer\"%>\n" );
+	page.add_callback( "user", [] { return "alice"; } );
+	page.add_callback<int>( "body", []( int n ) {
+		return std::string( static_cast<std::size_t>( n ), 'x' );
+	} );
+	page.finalize( );
+	auto const expected = std::string(
+	  "<html><body><nav>alice</nav><main>xxxxx</main><footer>(c)</footer></body></html>\n" );
+	ok &= check( page.to_string( ) == expected, "Unexpected output" );
+	ok &= check( page.to_string( ) == expected, "Unexpected output when the footer is cached" );
+
+	// "<html><body><nav>" is one literal, as is "</nav><main>"
+	auto literal_only = includes.compile( "a<%include args=\"nav\"%>b" );
+	literal_only.add_callback( "user", [] { return "u"; } );
+	ok &= check( literal_only.part_count( ) == 3, "Literal text should merge across includes" );
+	ok &= check( literal_only.to_string( ) == "a<nav>u</nav>b", "Unexpected merged output" );
+
+	// Blocks are spliced too
+	includes.add( "maybe", "<%if args=\"flag\"%>yes<%else%>no<%endif%>" );
+	auto with_block = includes.compile( "<%include args=\"maybe\"%>!" );
+	with_block.add_block_callback( "flag", [] { return true; } );
+	ok &= check( with_block.to_string( ) == "yes!", "Unexpected output of an included block" );
+
+	// Callbacks of included templates are bound by the including template
+	auto unbound = includes.compile( "<%include args=\"nav\"%>" );
+	ok &= check( not error_from( [&] { (void)unbound.to_string( ); } ).empty( ),
+	             "Unbound included callbacks should be reported" );
+
+	ok &= check( error_from( [&] { (void)includes.compile( "<%include args=\"missing\"%>" ); } )
+	               .find( "missing" ) != std::string::npos,
+	             "Unknown includes should be reported" );
+	ok &= check( not error_from( [] { (void)daw::parse_template( "<%include args=\"nav\"%>" ); } )
+	                   .empty( ),
+	             "Includes without a template set should be reported" );
+
+	includes.add( "a", "a<%include args=\"b\"%>" );
+	includes.add( "b", "b<%include args=\"a\"%>" );
+	auto const cycle = error_from( [&] { (void)includes.compile( "<%include args=\"a\"%>" ); } );
+	ok &= check( cycle == "Include cycle: a -> b -> a", "Include cycles should be reported" );
+	// The set is still usable after an error
+	ok &= check( includes.find( "nav" ) != nullptr, "Set unusable after an error" );
+
+	return daw::parse_template_test::test_result( "template_includes_test", ok );
+}
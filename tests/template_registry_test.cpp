@@ -0,0 +1,120 @@
+// The MIT License (MIT)
+//
+// Copyright (c) Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+// Checks that template_registry compiles a directory of templates, serves them by name, and swaps
+// in new versions on reload while earlier versions stay usable
+
+#include <daw/daw_template_registry.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+
+namespace {
+	std::size_t failures = 0;
+
+	void check( bool condition, char const *message ) {
+		if( not condition ) {
+			std::cerr << "Failed: " << message << '\n';
+			++failures;
+		}
+	}
+
+	void write_file( std::filesystem::path const &path, std::string const &contents ) {
+		auto const existed = std::filesystem::exists( path );
+		auto const old_time = existed ? std::filesystem::last_write_time( path )
+		                              : std::filesystem::file_time_type( );
+		{
+			auto out = std::ofstream( path, std::ios::binary | std::ios::trunc );
+			out << contents;
+		}
+		// Ensure the change is seen even when the file system has a coarse timestamp resolution
+		if( existed ) {
+			std::filesystem::last_write_time( path, old_time + std::chrono::seconds( 2 ) );
+		}
+	}
+} // namespace
+
+int main( ) {
+	auto const unique = std::chrono::steady_clock::now( ).time_since_epoch( ).count( );
+	auto const dir = std::filesystem::temp_directory_path( ) /
+	                 ( "daw_template_registry_test_" + std::to_string( unique ) );
+	std::filesystem::create_directories( dir / "emails" );
+	write_file( dir / "index.shtml", "Hello <%call args=\"user\"%>!" );
+	write_file( dir / "emails" / "welcome.shtml",
+	            "Welcome <%call args=\"user\"%>, #<%call args=\"id,5\"%>." );
+	write_file( dir / "notes.txt", "Not a template" );
+
+	auto callbacks = daw::callback_set( );
+	callbacks.add_callback( "user", []( ) { return "Ada"; } );
+	callbacks.add_callback<int>( "id", []( int n ) { return n * 2; } );
+
+	{
+		auto registry = daw::template_registry( dir, callbacks, { ".shtml" } );
+		check( registry.size( ) == 2, "Two templates loaded" );
+		auto const index = registry.get( "index.shtml" );
+		check( index and index->to_string( ) == "Hello Ada!", "index.shtml renders" );
+		auto const welcome = registry.get( "emails/welcome.shtml" );
+		check( welcome and welcome->to_string( ) == "Welcome Ada, #10.", "welcome.shtml renders" );
+		check( not registry.get( "notes.txt" ), "Files without a template extension are skipped" );
+
+		check( registry.reload( ) == 0, "Unchanged files are not recompiled" );
+		check( registry.get( "index.shtml" ) == index, "Unchanged templates are kept" );
+
+		write_file( dir / "index.shtml", "Goodbye <%call args=\"user\"%>!" );
+		check( registry.reload( ) == 1, "A modified file is recompiled" );
+		check( registry.get( "index.shtml" )->to_string( ) == "Goodbye Ada!", "New version served" );
+		check( index->to_string( ) == "Hello Ada!", "Old version still renders" );
+
+		write_file( dir / "index.shtml", "Broken <%call args=\"missing\"%>!" );
+		registry.reload( );
+		check( registry.failures( ).size( ) == 1 and registry.failures( )[0].name == "index.shtml",
+		       "A template that does not compile is reported" );
+		check( registry.get( "index.shtml" )->to_string( ) == "Goodbye Ada!",
+		       "The last good version is served after a failed compile" );
+
+		std::filesystem::remove( dir / "index.shtml" );
+		check( registry.reload( ) == 1, "A removed file is reported as a change" );
+		check( not registry.get( "index.shtml" ), "A removed template is no longer served" );
+		check( registry.failures( ).empty( ), "Failures for removed files are forgotten" );
+
+		registry.watch( std::chrono::milliseconds( 10 ) );
+		write_file( dir / "added.shtml", "Added <%call args=\"user\"%>." );
+		for( int n = 0; n < 500 and not registry.get( "added.shtml" ); ++n ) {
+			std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+		}
+		check( registry.get( "added.shtml" ) and
+		         registry.get( "added.shtml" )->to_string( ) == "Added Ada.",
+		       "The watcher picks up new files" );
+		registry.stop_watching( );
+	}
+	std::filesystem::remove_all( dir );
+	if( failures == 0 ) {
+		std::cout << "template_registry_test passed\n";
+	}
+	return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
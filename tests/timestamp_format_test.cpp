@@ -0,0 +1,99 @@
+// The MIT License (MIT)
+//
+// Copyright (c) Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+// Checks that the compiled timestamp formatter produces the same output as date::format for every
+// flag in date_formatting.md
+
+#include <daw/daw_parse_template_timestamp.h>
+
+#include <date/date.h>
+#include <date/tz.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+int main( ) {
+	using namespace std::chrono;
+	// Flags that come from the locale and may differ between platforms use date::format
+	std::vector<std::string> const fallback_flags = { "%c", "%r", "%x", "%X" };
+	std::vector<std::string> const flags = {
+	  "%a", "%A", "%b", "%B", "%c", "%C", "%d", "%D", "%e",  "%F",  "%g",   "%G",
+	  "%h", "%H", "%I", "%j", "%m", "%M", "%n", "%p", "%r",  "%R",  "%S",   "%t",
+	  "%T", "%u", "%U", "%V", "%w", "%W", "%x", "%X", "%y",  "%Y",  "%z",   "%Ez",
+	  "%Oz", "%Z", "%%", "%Y-%m-%dT%T%z", "%a, %d %b %Y %T %Z", "Week %V of %G, day %j" };
+
+	std::vector<date::time_zone const *> const zones = { date::current_zone( ),
+	                                                     date::locate_zone( "Etc/UTC" ),
+	                                                     date::locate_zone( "America/New_York" ),
+	                                                     date::locate_zone( "America/St_Johns" ),
+	                                                     date::locate_zone( "Europe/Berlin" ),
+	                                                     date::locate_zone( "Asia/Kolkata" ),
+	                                                     date::locate_zone( "Australia/Lord_Howe" ),
+	                                                     date::locate_zone( "Etc/GMT-12" ) };
+
+	// Cover every day of the week/year boundaries and a spread of times through the day
+	std::vector<date::sys_seconds> time_points{ };
+	for( auto tp = date::sys_seconds( seconds( 0 ) ); tp < date::sys_seconds( seconds( 2208988800 ) );
+	     tp += hours( 24 * 3 + 7 ) + minutes( 13 ) + seconds( 17 ) ) {
+		time_points.push_back( tp );
+	}
+	for( int year = 1970; year < 2040; ++year ) {
+		auto const new_year = date::sys_seconds(
+		  seconds( ( static_cast<long long>( year ) - 1970 ) * 31556952LL ) );
+		for( int day = -10; day <= 10; ++day ) {
+			time_points.push_back( date::floor<date::days>( new_year ) + date::days( day ) +
+			                       hours( day + 10 ) );
+		}
+	}
+
+	std::size_t failures = 0;
+	std::size_t checks = 0;
+	for( auto const &fmt : flags ) {
+		auto const formatter = daw::parse_template_impl::timestamp_formatter( fmt );
+		bool const expect_fallback =
+		  std::find( fallback_flags.begin( ), fallback_flags.end( ), fmt ) != fallback_flags.end( );
+		if( formatter.uses_fallback( ) != expect_fallback ) {
+			std::cerr << "Unexpected fallback state for '" << fmt << "'\n";
+			++failures;
+		}
+		for( auto const *tz : zones ) {
+			for( auto const &tp : time_points ) {
+				++checks;
+				auto const expected = date::format( fmt, date::make_zoned( tz, tp ) );
+				auto const result = formatter.format( tz, tp );
+				if( result != expected ) {
+					if( ++failures < 50 ) {
+						std::cerr << "Mismatch for '" << fmt << "' in " << tz->name( ) << " at "
+						          << tp.time_since_epoch( ).count( ) << ": expected '" << expected
+						          << "' got '" << result << "'\n";
+					}
+				}
+			}
+		}
+	}
+	std::cout << checks << " checks, " << failures << " failures\n";
+	return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
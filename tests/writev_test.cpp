@@ -0,0 +1,87 @@
+// The MIT License (MIT)
+//
+// Copyright (c) Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+// Checks that scatter/gather rendering produces the same output as to_string, including when the
+// render has more segments than a single writev call accepts
+
+#include <daw/daw_parse_template.h>
+#include <daw/daw_parse_template_writev.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <system_error>
+
+#if defined( DAW_PARSE_TEMPLATE_HAS_WRITEV )
+#include <unistd.h>
+#endif
+
+int main( ) {
+	auto template_str = std::string( );
+	for( int n = 0; n < 5000; ++n ) {
+		auto const row = std::to_string( n );
+		template_str += "<li>" + row + ": <%call args=\"item," + row + "\"%></li>\n";
+	}
+	auto tmp = daw::parse_template( template_str );
+	tmp.add_callback<int>( "item", []( int value ) { return value * 3; } );
+	tmp.finalize( );
+	auto const expected = tmp.to_string( );
+
+	auto output = daw::scatter_gather_output( );
+	output.render( tmp );
+	if( output.size( ) != expected.size( ) or output.to_string( ) != expected ) {
+		std::cerr << "scatter_gather_output does not match to_string\n";
+		return EXIT_FAILURE;
+	}
+	// Each line is a literal, a call result, and the next literal.  Adjacent literals are merged
+	if( output.segment_count( ) != 2 * 5000 + 1 ) {
+		std::cerr << "Unexpected segment count " << output.segment_count( ) << '\n';
+		return EXIT_FAILURE;
+	}
+
+#if defined( DAW_PARSE_TEMPLATE_HAS_WRITEV )
+	std::FILE *file = std::tmpfile( );
+	if( file == nullptr ) {
+		std::cerr << "Unable to create temporary file\n";
+		return EXIT_FAILURE;
+	}
+	int const fd = fileno( file );
+	auto ec = std::error_code( );
+	auto const written = daw::write_to_fd( fd, tmp, ec );
+	if( ec or written != expected.size( ) ) {
+		std::cerr << "write_to_fd failed: " << ec.message( ) << '\n';
+		return EXIT_FAILURE;
+	}
+	auto result = std::string( expected.size( ), '\0' );
+	if( ::pread( fd, result.data( ), result.size( ), 0 ) !=
+	      static_cast<ssize_t>( result.size( ) ) or
+	    result != expected ) {
+		std::cerr << "File contents do not match to_string\n";
+		return EXIT_FAILURE;
+	}
+	std::fclose( file );
+#endif
+	std::cout << "writev_test passed\n";
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,88 @@
+// The MIT License (MIT)
+//
+// Copyright (c) Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+// Checks that zones are resolved once per name, and that the offsets found in a resolved zone's
+// transitions match those of the time zone inside and outside of the transitions
+
+#include "parse_template_test.h"
+
+#include <daw/daw_parse_template.h>
+
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using daw::parse_template_test::check;
+
+namespace {
+	bool same_info( date::sys_info const &lhs, date::sys_info const &rhs ) {
+		return lhs.begin == rhs.begin and lhs.end == rhs.end and lhs.offset == rhs.offset and
+		       lhs.save == rhs.save and lhs.abbrev == rhs.abbrev;
+	}
+} // namespace
+
+int main( ) {
+	using daw::parse_template_impl::resolve_zone;
+	bool ok = true;
+
+	ok &= check( &resolve_zone( "America/New_York" ) == &resolve_zone( "America/New_York" ),
+	             "Expected one zone per name" );
+	ok &= check( resolve_zone( "" ).tz( ) == date::current_zone( ),
+	             "Expected the system's time zone for an empty name" );
+	ok &= check( resolve_zone( "" ).name( ).empty( ), "Expected no name for the system's zone" );
+	ok &= check( resolve_zone( "Europe/Berlin" ).name( ) == "Europe/Berlin", "Unexpected name" );
+
+	// Every 5 days from 2 years ago to 25 years from now, which goes past both ends of the
+	// transitions
+	using namespace std::chrono;
+	auto const now = floor<seconds>( system_clock::now( ) );
+	for( auto name :
+	     { "", "America/New_York", "Europe/Berlin", "Australia/Lord_Howe", "Etc/GMT-12" } ) {
+		auto const &zone = resolve_zone( name );
+		for( auto tp = date::sys_seconds( now - hours( 24 * 365 * 2 ) );
+		     tp < now + hours( 24 * 365 * 25 );
+		     tp += hours( 24 * 5 ) + seconds( 1 ) ) {
+			auto fallback = date::sys_info{ };
+			if( not same_info( zone.info( tp, fallback ), zone.tz( )->get_info( tp ) ) ) {
+				std::cerr << "Unexpected offset for '" << name << "' at "
+				          << tp.time_since_epoch( ).count( ) << '\n';
+				ok = false;
+				break;
+			}
+		}
+	}
+
+	// Templates share the resolved zones
+	auto tmp = daw::parse_template( "<%date args=\"Asia/Kolkata\"%> <%time args=\"Asia/Kolkata\"%>" );
+	auto const rendered = tmp.to_string( );
+	ok &= check( rendered.size( ) == 19, "Unexpected date and time" );
+
+	bool threw = false;
+	try {
+		(void)resolve_zone( "Not/A_Zone" );
+	} catch( std::runtime_error const & ) { threw = true; }
+	ok &= check( threw, "Expected an error for an unknown zone" );
+
+	return daw::parse_template_test::test_result( "zone_resolver_test", ok );
+}